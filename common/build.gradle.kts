@@ -1,4 +1,5 @@
 import com.powersync.compile.CreatePowerSyncSqliteCoreCInterop
+import com.powersync.plugins.utils.jvmBenchmarks
 import com.powersync.plugins.utils.powersyncTargets
 import de.undercouch.gradle.tasks.download.Download
 import org.gradle.api.tasks.testing.logging.TestExceptionFormat
@@ -210,8 +211,9 @@ kotlin {
                 implementation(libs.uuid)
                 implementation(libs.kotlin.stdlib)
                 implementation(libs.ktor.client.contentnegotiation)
+                implementation(libs.ktor.client.encoding)
                 implementation(libs.ktor.serialization.json)
-                implementation(libs.kotlinx.io)
+                api(libs.kotlinx.io)
                 implementation(libs.kotlinx.coroutines.core)
                 implementation(libs.kotlinx.datetime)
                 implementation(libs.stately.concurrency)
@@ -271,6 +273,9 @@ val testWithJava8 by tasks.registering(KotlinJvmTest::class) {
 }
 tasks.named("check").configure { dependsOn(testWithJava8) }
 
+// Benchmarks in jvmTest only run with ./gradlew :common:jvmBenchmark
+jvmBenchmarks()
+
 tasks.withType<KotlinTest> {
     testLogging {
         events("PASSED", "FAILED", "SKIPPED")
@@ -3,17 +3,20 @@ package com.powersync
 import app.cash.turbine.turbineScope
 import co.touchlab.kermit.ExperimentalKermitApi
 import com.powersync.attachments.Attachment
+import com.powersync.attachments.AttachmentCacheOptions
 import com.powersync.attachments.AttachmentQueue
 import com.powersync.attachments.AttachmentState
 import com.powersync.attachments.RemoteStorage
 import com.powersync.attachments.SyncErrorHandler
 import com.powersync.attachments.WatchedAttachmentItem
 import com.powersync.attachments.createAttachmentsTable
+import com.powersync.attachments.sync.AttachmentTransferLimits
 import com.powersync.db.getString
 import com.powersync.db.schema.Schema
 import com.powersync.db.schema.Table
 import com.powersync.test.getTempDir
 import com.powersync.testutils.ActiveDatabaseTest
+import com.powersync.testutils.HttpRemoteStorage
 import com.powersync.testutils.MockedRemoteStorage
 import com.powersync.testutils.UserRow
 import com.powersync.testutils.databaseTest
@@ -27,12 +30,34 @@ import dev.mokkery.spy
 import dev.mokkery.verifySuspend
 import io.kotest.matchers.shouldBe
 import io.kotest.matchers.shouldNotBe
+import io.ktor.client.HttpClient
+import io.ktor.client.engine.mock.MockEngine
+import io.ktor.client.engine.mock.respond
+import io.ktor.client.request.HttpRequestData
+import io.ktor.http.HttpHeaders
+import io.ktor.http.HttpStatusCode
+import io.ktor.http.headersOf
+import io.ktor.utils.io.ByteChannel
+import io.ktor.utils.io.writeByteArray
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.delay
 import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.distinctUntilChanged
+import kotlinx.coroutines.flow.first
 import kotlinx.coroutines.flow.flowOf
 import kotlinx.coroutines.flow.onEach
+import kotlinx.coroutines.flow.toList
+import kotlinx.coroutines.flow.update
+import kotlinx.coroutines.flow.updateAndGet
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.withContext
+import kotlinx.io.IOException
 import kotlinx.io.files.Path
+import kotlin.random.Random
 import kotlin.test.Test
+import kotlin.time.Duration.Companion.milliseconds
 import kotlin.time.Duration.Companion.seconds
 
 @OptIn(ExperimentalKermitApi::class)
@@ -512,6 +537,403 @@ class AttachmentsTest {
             }
         }
 
+    @Test
+    fun testConcurrentDownloads() =
+        databaseTest {
+            updateSchema(database)
+
+            val activeDownloads = MutableStateFlow(0)
+            val peakDownloads = MutableStateFlow(0)
+            val releaseDownloads = CompletableDeferred<Unit>()
+            val remote =
+                object : RemoteStorage by MockedRemoteStorage() {
+                    override suspend fun downloadFile(attachment: Attachment): Flow<ByteArray> {
+                        val active = activeDownloads.updateAndGet { it + 1 }
+                        peakDownloads.update { maxOf(it, active) }
+                        try {
+                            releaseDownloads.await()
+                        } finally {
+                            activeDownloads.update { it - 1 }
+                        }
+                        return flowOf(ByteArray(1))
+                    }
+                }
+
+            val queue =
+                AttachmentQueue(
+                    db = database,
+                    remoteStorage = remote,
+                    attachmentsDirectory = getAttachmentsDir(),
+                    watchAttachments = { watchAttachments(database) },
+                    logger = logger,
+                    transferLimits = AttachmentTransferLimits(maxConcurrentDownloads = 2),
+                )
+
+            doOnCleanup {
+                queue.stopSyncing()
+                queue.clearQueue()
+                queue.close()
+            }
+
+            queue.startSync()
+
+            database.execute(
+                // language=SQL
+                """
+                    INSERT INTO
+                        users (id, name, email, photo_id)
+                    VALUES
+                        (uuid(), "steven", "steven@journeyapps.com", uuid()),
+                        (uuid(), "simon", "simon@journeyapps.com", uuid()),
+                        (uuid(), "ralf", "ralf@journeyapps.com", uuid())
+                """,
+            )
+
+            // Two downloads should start without waiting for each other
+            activeDownloads.first { it == 2 }
+            releaseDownloads.complete(Unit)
+
+            watchAttachmentsTable().first { attachments ->
+                attachments.size == 3 && attachments.all { it.state == AttachmentState.SYNCED }
+            }
+            peakDownloads.value shouldBe 2
+        }
+
+    @Test
+    fun testDownloadsWithUnknownSizeUseBudget() =
+        databaseTest {
+            updateSchema(database)
+
+            val activeDownloads = MutableStateFlow(0)
+            val peakDownloads = MutableStateFlow(0)
+            val releaseDownloads = CompletableDeferred<Unit>()
+            val remote =
+                object : RemoteStorage by MockedRemoteStorage() {
+                    override suspend fun downloadFile(attachment: Attachment): Flow<ByteArray> {
+                        val active = activeDownloads.updateAndGet { it + 1 }
+                        peakDownloads.update { maxOf(it, active) }
+                        try {
+                            releaseDownloads.await()
+                        } finally {
+                            activeDownloads.update { it - 1 }
+                        }
+                        return flowOf(ByteArray(1))
+                    }
+                }
+
+            val queue =
+                AttachmentQueue(
+                    db = database,
+                    remoteStorage = remote,
+                    attachmentsDirectory = getAttachmentsDir(),
+                    watchAttachments = { watchAttachments(database) },
+                    logger = logger,
+                    // Each download of unknown size takes up the entire budget.
+                    transferLimits =
+                        AttachmentTransferLimits(
+                            maxConcurrentDownloads = 3,
+                            maxInFlightBytes = 1024,
+                            unknownSizeEstimate = 1024,
+                        ),
+                )
+
+            doOnCleanup {
+                queue.stopSyncing()
+                queue.clearQueue()
+                queue.close()
+            }
+
+            queue.startSync()
+
+            database.execute(
+                // language=SQL
+                """
+                    INSERT INTO
+                        users (id, name, email, photo_id)
+                    VALUES
+                        (uuid(), "steven", "steven@journeyapps.com", uuid()),
+                        (uuid(), "simon", "simon@journeyapps.com", uuid()),
+                        (uuid(), "ralf", "ralf@journeyapps.com", uuid())
+                """,
+            )
+
+            activeDownloads.first { it == 1 }
+            // Give other downloads a chance to start if they weren't limited by the budget.
+            withContext(Dispatchers.Default) { delay(200.milliseconds) }
+            releaseDownloads.complete(Unit)
+
+            watchAttachmentsTable().first { attachments ->
+                attachments.size == 3 && attachments.all { it.state == AttachmentState.SYNCED }
+            }
+            peakDownloads.value shouldBe 1
+        }
+
+    @Test
+    fun testContentCacheSharesFiles() =
+        databaseTest {
+            updateSchema(database)
+
+            val downloads = MutableStateFlow(0)
+            val remote =
+                object : RemoteStorage by MockedRemoteStorage() {
+                    override suspend fun downloadFile(attachment: Attachment): Flow<ByteArray> {
+                        downloads.update { it + 1 }
+                        return flowOf(ByteArray(1))
+                    }
+                }
+
+            val queue =
+                AttachmentQueue(
+                    db = database,
+                    remoteStorage = remote,
+                    attachmentsDirectory = getAttachmentsDir(),
+                    watchAttachments = {
+                        database.watch("SELECT photo_id FROM users WHERE photo_id IS NOT NULL") {
+                            // All photos have the same contents.
+                            WatchedAttachmentItem(
+                                id = it.getString("photo_id"),
+                                fileExtension = "jpg",
+                                contentHash = "shared",
+                            )
+                        }
+                    },
+                    logger = logger,
+                    cacheOptions = AttachmentCacheOptions(maxBytes = 0),
+                )
+
+            doOnCleanup {
+                queue.stopSyncing()
+                queue.clearQueue()
+                queue.close()
+            }
+
+            queue.startSync()
+
+            database.execute(
+                // language=SQL
+                """
+                    INSERT INTO
+                        users (id, name, email, photo_id)
+                    VALUES
+                        (uuid(), "steven", "steven@journeyapps.com", uuid()),
+                        (uuid(), "simon", "simon@journeyapps.com", uuid())
+                """,
+            )
+
+            val synced =
+                watchAttachmentsTable().first { attachments ->
+                    attachments.size == 2 && attachments.all { it.state == AttachmentState.SYNCED }
+                }
+            val localUri = synced.map { it.localUri }.distinct().single()!!
+            downloads.value shouldBe 1
+
+            // The contents are still referenced by the other attachment.
+            database.execute("UPDATE users SET photo_id = NULL WHERE name = 'steven'")
+            watchAttachmentsTable().first { attachments ->
+                attachments.count { it.state == AttachmentState.SYNCED } == 1
+            }
+            queue.localStorage.fileExists(localUri) shouldBe true
+
+            // Unreferenced contents exceed the cache size, so they're evicted.
+            database.execute("UPDATE users SET photo_id = NULL")
+            watchAttachmentsTable().first { it.isEmpty() }
+            queue.localStorage.fileExists(localUri) shouldBe false
+        }
+
+    @Test
+    fun testSavingAttachmentsKeepsRecordedAccess() =
+        databaseTest {
+            updateSchema(database)
+
+            val queue =
+                AttachmentQueue(
+                    db = database,
+                    remoteStorage = MockedRemoteStorage(),
+                    attachmentsDirectory = getAttachmentsDir(),
+                    watchAttachments = { watchAttachments(database) },
+                    logger = logger,
+                )
+
+            doOnCleanup {
+                queue.stopSyncing()
+                queue.clearQueue()
+                queue.close()
+            }
+
+            queue.startSync()
+
+            database.execute(
+                // language=SQL
+                """
+                    INSERT INTO
+                        users (id, name, email, photo_id)
+                    VALUES
+                        (uuid(), "steven", "steven@journeyapps.com", uuid())
+                """,
+            )
+
+            // A copy read by a sync pass before the access has been recorded.
+            val stale =
+                watchAttachmentsTable()
+                    .first { it.singleOrNull()?.state == AttachmentState.SYNCED }
+                    .single()
+            stale.lastAccessedAt shouldBe null
+
+            queue.recordAccess(stale.id)
+            queue.attachmentsService.withContext { it.saveAttachments(listOf(stale)) }
+
+            val saved = database.get("SELECT * FROM attachments") { Attachment.fromCursor(it) }
+            saved.lastAccessedAt shouldNotBe null
+        }
+
+    @Test
+    fun testResumesInterruptedDownloads() =
+        databaseTest {
+            updateSchema(database)
+
+            val contents = Random.nextBytes(10_000)
+            val etag = "\"v1\""
+            val requests = mutableListOf<HttpRequestData>()
+            lateinit var remote: HttpRemoteStorage
+            val server =
+                MockEngine { request ->
+                    requests.add(request)
+                    val range = request.headers[HttpHeaders.Range]
+                    if (range == null) {
+                        // Send the first 4000 bytes, then drop the connection.
+                        val body = ByteChannel()
+                        body.writeByteArray(contents.copyOfRange(0, 4000))
+                        body.flush()
+                        scope.launch {
+                            remote.bytesReceived.first { it >= 4000 }
+                            body.cancel(IOException("Connection reset"))
+                        }
+                        respond(body, HttpStatusCode.OK, headersOf(HttpHeaders.ETag, etag))
+                    } else {
+                        request.headers[HttpHeaders.IfRange] shouldBe etag
+                        val start = range.removePrefix("bytes=").removeSuffix("-").toInt()
+                        respond(
+                            contents.copyOfRange(start, contents.size),
+                            HttpStatusCode.PartialContent,
+                            headersOf(HttpHeaders.ETag, etag),
+                        )
+                    }
+                }
+            remote = HttpRemoteStorage(HttpClient(server))
+
+            val queue =
+                AttachmentQueue(
+                    db = database,
+                    remoteStorage = remote,
+                    attachmentsDirectory = getAttachmentsDir(),
+                    watchAttachments = { watchAttachments(database) },
+                    logger = logger,
+                )
+
+            doOnCleanup {
+                queue.stopSyncing()
+                queue.clearQueue()
+                queue.close()
+            }
+
+            queue.startSync()
+
+            database.execute(
+                // language=SQL
+                """
+                    INSERT INTO
+                        users (id, name, email, photo_id)
+                    VALUES
+                        (uuid(), "steven", "steven@journeyapps.com", uuid())
+                """,
+            )
+
+            val attachment =
+                watchAttachmentsTable()
+                    .first { it.singleOrNull()?.state == AttachmentState.SYNCED }
+                    .single()
+
+            requests.map { it.headers[HttpHeaders.Range] } shouldBe listOf(null, "bytes=4000-")
+            attachment.size shouldBe contents.size.toLong()
+            attachment.downloadOffset shouldBe null
+
+            val stored = queue.localStorage.readFile(attachment.localUri!!).toList()
+            stored.reduce { acc, bytes -> acc + bytes }.contentEquals(contents) shouldBe true
+        }
+
+    @Test
+    fun testRestartsDownloadsWithUnexpectedFileSize() =
+        databaseTest {
+            updateSchema(database)
+
+            val contents = Random.nextBytes(10_000)
+            val etag = "\"v1\""
+            val requests = mutableListOf<HttpRequestData>()
+            lateinit var remote: HttpRemoteStorage
+            lateinit var queue: AttachmentQueue
+            val server =
+                MockEngine { request ->
+                    requests.add(request)
+                    if (requests.size == 1) {
+                        // Send the first 4000 bytes, then drop the connection after more bytes than
+                        // the recorded offset have made it into the file.
+                        val body = ByteChannel()
+                        body.writeByteArray(contents.copyOfRange(0, 4000))
+                        body.flush()
+                        scope.launch {
+                            remote.bytesReceived.first { it >= 4000 }
+                            val path = queue.getLocalUri(request.url.segments.last())
+                            queue.localStorage.saveFile(path, flowOf(contents.copyOfRange(0, 4100)))
+                            body.cancel(IOException("Connection reset"))
+                        }
+                        respond(body, HttpStatusCode.OK, headersOf(HttpHeaders.ETag, etag))
+                    } else {
+                        respond(contents, HttpStatusCode.OK, headersOf(HttpHeaders.ETag, etag))
+                    }
+                }
+            remote = HttpRemoteStorage(HttpClient(server))
+
+            queue =
+                AttachmentQueue(
+                    db = database,
+                    remoteStorage = remote,
+                    attachmentsDirectory = getAttachmentsDir(),
+                    watchAttachments = { watchAttachments(database) },
+                    logger = logger,
+                )
+
+            doOnCleanup {
+                queue.stopSyncing()
+                queue.clearQueue()
+                queue.close()
+            }
+
+            queue.startSync()
+
+            database.execute(
+                // language=SQL
+                """
+                    INSERT INTO
+                        users (id, name, email, photo_id)
+                    VALUES
+                        (uuid(), "steven", "steven@journeyapps.com", uuid())
+                """,
+            )
+
+            val attachment =
+                watchAttachmentsTable()
+                    .first { it.singleOrNull()?.state == AttachmentState.SYNCED }
+                    .single()
+
+            // The local file doesn't match the offset recorded for the first attempt, so the
+            // download starts over instead of appending to it.
+            requests.map { it.headers[HttpHeaders.Range] } shouldBe listOf(null, null)
+            attachment.size shouldBe contents.size.toLong()
+
+            val stored = queue.localStorage.readFile(attachment.localUri!!).toList()
+            stored.reduce { acc, bytes -> acc + bytes }.contentEquals(contents) shouldBe true
+        }
+
     @Test
     fun testSkipFailedDownload() =
         databaseTest {
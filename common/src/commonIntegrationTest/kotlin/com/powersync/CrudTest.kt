@@ -1,6 +1,8 @@
 package com.powersync
 
+import com.powersync.db.crud.CrudEncoding
 import com.powersync.db.crud.UpdateType
+import com.powersync.db.crud.uploadCrudTransactions
 import com.powersync.db.schema.Column
 import com.powersync.db.schema.RawTable
 import com.powersync.db.schema.RawTableSchema
@@ -9,8 +11,18 @@ import com.powersync.db.schema.Table
 import com.powersync.db.schema.TableOptions
 import com.powersync.db.schema.TrackPreviousValuesOptions
 import com.powersync.testutils.databaseTest
+import com.powersync.utils.JsonUtil
+import io.kotest.assertions.throwables.shouldThrow
 import io.kotest.matchers.collections.shouldHaveSize
 import io.kotest.matchers.shouldBe
+import kotlinx.coroutines.delay
+import kotlinx.io.Buffer
+import kotlinx.io.readString
+import kotlinx.serialization.json.add
+import kotlinx.serialization.json.buildJsonArray
+import kotlinx.serialization.json.buildJsonObject
+import kotlinx.serialization.json.jsonObject
+import kotlinx.serialization.json.put
 import kotlin.test.Test
 
 class CrudTest {
@@ -252,4 +264,77 @@ class CrudTest {
             write.opData shouldBe mapOf("name" to "updated_name")
             write.previousValues shouldBe mapOf("name" to "name")
         }
+
+    @Test
+    @OptIn(ExperimentalPowerSyncAPI::class)
+    fun writeCrudBatch() =
+        databaseTest {
+            database.updateSchema(Schema(Table("lists", listOf(Column.text("name")))))
+            repeat(3) {
+                database.execute("INSERT INTO lists (id, name) VALUES (?, ?)", listOf("id$it", "list $it"))
+            }
+
+            val buffer = Buffer()
+            val batch = database.writeCrudBatch(buffer, limit = 2, fields = setOf("op", "id"))!!
+            batch.size shouldBe 2
+            batch.hasMore shouldBe true
+            JsonUtil.json.parseToJsonElement(buffer.readString()) shouldBe
+                buildJsonArray {
+                    add(buildJsonObject { put("op", "PUT"); put("id", "id0") })
+                    add(buildJsonObject { put("op", "PUT"); put("id", "id1") })
+                }
+
+            batch.complete()
+            val remaining = database.writeCrudBatch(buffer, encoding = CrudEncoding.NDJSON)!!
+            remaining.hasMore shouldBe false
+            val line = buffer.readString()
+            line.endsWith("\n") shouldBe true
+            JsonUtil.json.parseToJsonElement(line.trim()).jsonObject["data"] shouldBe buildJsonObject { put("name", "list 2") }
+
+            remaining.complete()
+            database.writeCrudBatch(buffer) shouldBe null
+            buffer.size shouldBe 0L
+        }
+
+    @Test
+    @OptIn(ExperimentalPowerSyncAPI::class)
+    fun uploadCrudTransactionsConcurrently() =
+        databaseTest {
+            database.updateSchema(Schema(Table("lists", listOf(Column.text("name")))))
+            repeat(5) {
+                database.execute("INSERT INTO lists (id, name) VALUES (uuid(), ?)", listOf("list $it"))
+            }
+
+            val uploaded = mutableListOf<Int?>()
+            database.uploadCrudTransactions(prefetch = 2, maxConcurrentUploads = 3) { tx ->
+                // Let later transactions finish first.
+                delay(100L - tx.crud[0].clientId * 10L)
+                uploaded.add(tx.transactionId)
+                null
+            }
+
+            uploaded shouldHaveSize 5
+            database.getNextCrudTransaction() shouldBe null
+        }
+
+    @Test
+    @OptIn(ExperimentalPowerSyncAPI::class)
+    fun uploadCrudTransactionsKeepsFailedTransactions() =
+        databaseTest {
+            database.updateSchema(Schema(Table("lists", listOf(Column.text("name")))))
+            repeat(4) {
+                database.execute("INSERT INTO lists (id, name) VALUES (uuid(), ?)", listOf("list $it"))
+            }
+
+            var attempts = 0
+            shouldThrow<IllegalStateException> {
+                database.uploadCrudTransactions { tx ->
+                    if (++attempts == 3) error("upload failed")
+                    null
+                }
+            }
+
+            // The first two transactions have been uploaded and completed.
+            database.getAll("SELECT 1 FROM ps_crud") { } shouldHaveSize 2
+        }
 }
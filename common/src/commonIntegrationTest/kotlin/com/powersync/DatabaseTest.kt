@@ -1,32 +1,42 @@
 package com.powersync
 
 import androidx.sqlite.SQLiteConnection
+import androidx.sqlite.SQLiteStatement
 import app.cash.turbine.test
 import app.cash.turbine.turbineScope
 import co.touchlab.kermit.ExperimentalKermitApi
 import com.powersync.db.ActiveDatabaseGroup
+import com.powersync.db.RowChange
+import com.powersync.db.SqlCursor
 import com.powersync.db.crud.CrudEntry
 import com.powersync.db.crud.CrudTransaction
+import com.powersync.db.driver.SessionRecordingConnection
 import com.powersync.db.getString
 import com.powersync.db.schema.PendingStatement
 import com.powersync.db.schema.PendingStatementParameter
 import com.powersync.db.schema.RawTable
 import com.powersync.db.schema.Schema
 import com.powersync.db.schema.TableOptions
+import com.powersync.test.factory
 import com.powersync.test.getTempDir
 import com.powersync.test.waitFor
 import com.powersync.testutils.UserRow
 import com.powersync.testutils.databaseTest
 import io.kotest.assertions.throwables.shouldThrow
+import io.kotest.assertions.throwables.shouldThrowAny
 import io.kotest.matchers.collections.shouldHaveSize
 import io.kotest.matchers.shouldBe
 import io.kotest.matchers.string.shouldContain
+import io.kotest.matchers.types.shouldBeInstanceOf
+import io.kotest.matchers.types.shouldBeSameInstanceAs
+import io.kotest.matchers.types.shouldNotBeSameInstanceAs
 import kotlinx.coroutines.CompletableDeferred
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.async
 import kotlinx.coroutines.awaitCancellation
 import kotlinx.coroutines.cancelAndJoin
 import kotlinx.coroutines.delay
+import kotlinx.coroutines.flow.first
 import kotlinx.coroutines.flow.takeWhile
 import kotlinx.coroutines.launch
 import kotlinx.coroutines.runBlocking
@@ -411,6 +421,34 @@ class DatabaseTest {
             count shouldBe 0
         }
 
+    @Test
+    @OptIn(ExperimentalPowerSyncAPI::class)
+    fun updateSchemaDoesNotWaitForReaders() =
+        databaseTest {
+            database.execute("INSERT INTO users (id, name, email) VALUES (uuid(), ?, ?)", listOf("name", "email"))
+            val users = database.getAll("SELECT name FROM users") { it.getString("name") }
+
+            val inRead = CompletableDeferred<Unit>()
+            val release = CompletableDeferred<Unit>()
+            val reader =
+                scope.launch {
+                    database.useConnection(readOnly = true) {
+                        inRead.complete(Unit)
+                        release.await()
+                    }
+                }
+            inRead.await()
+
+            // The schema change completes while a reader is active.
+            database.updateSchema(schema = Schema(UserRow.table.copy(viewNameOverride = "people")))
+            database.getAll("SELECT name FROM people") { it.getString("name") } shouldBe users
+
+            // The connection used by the reader picks up the new schema once it's leased again.
+            release.complete(Unit)
+            reader.join()
+            database.getAll("SELECT name FROM people") { it.getString("name") } shouldBe users
+        }
+
     @Test
     fun viewOverride() =
         databaseTest {
@@ -587,6 +625,33 @@ class DatabaseTest {
             hadOtherWrite.await()
         }
 
+    @Test
+    @OptIn(ExperimentalPowerSyncAPI::class)
+    fun testCachedStatements() =
+        databaseTest {
+            // Statements must not be used outside of usePreparedCached, we only compare them here.
+            suspend fun prepare(sql: String = "SELECT name FROM users WHERE email = ?"): SQLiteStatement =
+                database.useConnection(readOnly = false) { raw ->
+                    raw.usePreparedCached("users", sql) { stmt ->
+                        stmt.bindText(1, "a@example.org")
+                        stmt.step() shouldBe false
+                        stmt
+                    }
+                }
+
+            val statement = prepare()
+            prepare() shouldBeSameInstanceAs statement
+
+            // Using the same key for another statement replaces it.
+            prepare("SELECT id FROM users WHERE email = ?") shouldNotBeSameInstanceAs statement
+            val replaced = prepare()
+            replaced shouldNotBeSameInstanceAs statement
+
+            // Schema changes close cached statements.
+            database.updateSchema(Schema(UserRow.table))
+            prepare() shouldNotBeSameInstanceAs replaced
+        }
+
     @Test
     fun testSoftClear() =
         databaseTest {
@@ -638,4 +703,166 @@ class DatabaseTest {
             db.disconnectAndClear()
             db.getAll("SELECT * FROM lists") { } shouldHaveSize 0
         }
+
+    @Test
+    fun testGroupCommit() =
+        databaseTest(createInitialDatabase = false) {
+            val db = openDatabase(groupCommitWindow = 10.milliseconds).also { it.readLock { } }
+
+            val writes =
+                List(10) { i ->
+                    scope.async {
+                        db.execute(
+                            "INSERT INTO users (id, name, email) VALUES (uuid(), ?, ?)",
+                            listOf("user $i", "user$i@example.org"),
+                        )
+                    }
+                }
+            writes.map { it.await() } shouldBe List(10) { 1L }
+
+            db.getAll("SELECT name FROM users") { it.getString(0)!! } shouldHaveSize 10
+            // All writes should have been committed in a single transaction.
+            db.get("SELECT COUNT(DISTINCT tx_id) FROM ps_crud") { it.getLong(0)!! } shouldBe 1L
+        }
+
+    @Test
+    fun testGroupCommitIsolatesFailures() =
+        databaseTest(createInitialDatabase = false) {
+            val db = openDatabase(groupCommitWindow = 10.milliseconds).also { it.readLock { } }
+
+            val first =
+                scope.async {
+                    db.execute("INSERT INTO users (id, name, email) VALUES (uuid(), ?, ?)", listOf("a", "a@example.org"))
+                }
+            val failing = scope.async { runCatching { db.execute("INSERT INTO does_not_exist VALUES (1)") } }
+            val second =
+                scope.async {
+                    db.execute("INSERT INTO users (id, name, email) VALUES (uuid(), ?, ?)", listOf("b", "b@example.org"))
+                }
+
+            first.await() shouldBe 1L
+            second.await() shouldBe 1L
+            failing.await().exceptionOrNull().shouldBeInstanceOf<PowerSyncException>()
+
+            db.getAll("SELECT name FROM users ORDER BY name") { it.getString(0)!! } shouldBe listOf("a", "b")
+        }
+
+    @Test
+    fun testConnectionErrorsAreReportedOnFirstUse() =
+        databaseTest(createInitialDatabase = false) {
+            val failingFactory =
+                object : PersistentConnectionFactory by factory {
+                    override fun openConnection(
+                        path: String,
+                        openFlags: Int,
+                    ): SQLiteConnection = throw IllegalStateException("Could not open database")
+                }
+
+            // Constructing the database must not open connections.
+            val db =
+                createPowerSyncDatabaseImpl(
+                    factory = failingFactory,
+                    schema = Schema(UserRow.table),
+                    dbFilename = "failing.db",
+                    dbDirectory = testDirectory,
+                    logger = logger,
+                    scope = scope,
+                )
+            doOnCleanup { db.close() }
+
+            shouldThrowAny { db.getAll("SELECT * FROM users") { } }
+        }
+
+    @Test
+    @OptIn(ExperimentalPowerSyncAPI::class)
+    fun testRowChangesOfFailedWriteLock() =
+        databaseTest {
+            // Row changes are only recorded by connections supporting the session extension.
+            val probe = factory.openConnection(databaseName, testDirectory)
+            val supported = probe is SessionRecordingConnection
+            probe.close()
+            if (!supported) return@databaseTest
+
+            turbineScope {
+                val changes = database.rowChanges(setOf("users")).testIn(this)
+
+                // Statements in a write lock autocommit, so the row is written despite the error.
+                shouldThrowAny {
+                    database.writeLock {
+                        it.execute(
+                            "INSERT INTO users (id, name, email) VALUES (uuid(), ?, ?)",
+                            listOf("Test", "test@example.org"),
+                        )
+                        throw IllegalStateException("write failed")
+                    }
+                }
+
+                changes.awaitItem().changes().map { it.operation } shouldBe listOf(RowChange.Operation.INSERT)
+                changes.cancel()
+            }
+
+            database.getAll("SELECT name FROM users") { it.getString(0)!! } shouldBe listOf("Test")
+        }
+
+    @Test
+    fun testGroupCommitRollsBackFailedCommit() =
+        databaseTest(createInitialDatabase = false) {
+            val db = openDatabase(groupCommitWindow = 10.milliseconds).also { it.readLock { } }
+            db.writeLock { it.execute("PRAGMA foreign_keys = ON") }
+            db.execute("CREATE TABLE local_parent (id INTEGER PRIMARY KEY)")
+            db.execute(
+                "CREATE TABLE local_child (id INTEGER PRIMARY KEY, parent INTEGER REFERENCES local_parent (id) DEFERRABLE INITIALLY DEFERRED)",
+            )
+
+            // The statement itself succeeds, but the deferred foreign key check fails the COMMIT.
+            shouldThrow<PowerSyncException> { db.execute("INSERT INTO local_child (id, parent) VALUES (1, 1)") }
+
+            // The write connection must not be left inside the failed transaction.
+            db.execute("INSERT INTO local_parent (id) VALUES (1)") shouldBe 1L
+            db.writeTransaction { it.execute("INSERT INTO local_child (id, parent) VALUES (1, 1)") }
+            db.getAll("SELECT id FROM local_child") { it.getLong(0)!! } shouldBe listOf(1L)
+        }
+
+    @Test
+    fun testSharedWatchQueries() =
+        databaseTest {
+            turbineScope {
+                val sql = "SELECT name, email FROM users"
+                val names = database.watch(sql) { it.getString("name") }.testIn(this)
+                val emails = database.watch(sql) { it.getString("email") }.testIn(this)
+
+                names.awaitItem() shouldHaveSize 0
+                emails.awaitItem() shouldHaveSize 0
+
+                database.execute(
+                    "INSERT INTO users (id, name, email) VALUES (uuid(), ?, ?)",
+                    listOf("Test", "test@example.org"),
+                )
+                names.awaitItem() shouldBe listOf("Test")
+                emails.awaitItem() shouldBe listOf("test@example.org")
+
+                // Both subscribers should have been served by the same query executions.
+                logWriter.logs.count { it.message == "Fetching watch() query: $sql" } shouldBe 2
+
+                names.cancel()
+                emails.cancel()
+            }
+        }
+
+    @Test
+    fun testWatchQueriesUseSqliteConversions() =
+        databaseTest {
+            val sql = "SELECT 1e20 AS r, 42 AS i, ' 12abc' AS t, x'3132' AS b"
+            val mapper: (SqlCursor) -> List<Any?> = { cursor ->
+                (0 until cursor.columnCount).flatMap { index ->
+                    listOf(cursor.getString(index), cursor.getLong(index), cursor.getDouble(index))
+                }
+            }
+
+            val watched = database.watch(sql, mapper = mapper).first().single()
+            watched.subList(0, 3) shouldBe listOf("1.0e+20", Long.MAX_VALUE, 1e20)
+            watched.subList(3, 6) shouldBe listOf("42", 42L, 42.0)
+            // Values read from watched queries should be converted like values read from the statement.
+            watched shouldBe database.get(sql, mapper = mapper)
+        }
 }
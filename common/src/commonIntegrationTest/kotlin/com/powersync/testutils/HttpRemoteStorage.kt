@@ -0,0 +1,72 @@
+package com.powersync.testutils
+
+import com.powersync.attachments.Attachment
+import com.powersync.attachments.DownloadResumePoint
+import com.powersync.attachments.PartialDownload
+import com.powersync.attachments.ResumableRemoteStorage
+import io.ktor.client.HttpClient
+import io.ktor.client.request.header
+import io.ktor.client.request.prepareGet
+import io.ktor.client.statement.bodyAsChannel
+import io.ktor.http.HttpHeaders
+import io.ktor.http.HttpStatusCode
+import io.ktor.utils.io.readAvailable
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.flow
+import kotlinx.coroutines.flow.update
+
+/**
+ * A [ResumableRemoteStorage] downloading attachments over HTTP, using `Range` requests to resume
+ * downloads.
+ */
+class HttpRemoteStorage(
+    private val client: HttpClient,
+) : ResumableRemoteStorage {
+    /**
+     * The total amount of bytes received and stored by downloads.
+     */
+    val bytesReceived = MutableStateFlow(0L)
+
+    override suspend fun downloadFileFrom(
+        attachment: Attachment,
+        resume: DownloadResumePoint?,
+        consume: suspend (download: PartialDownload) -> Unit,
+    ) {
+        client
+            .prepareGet("https://storage.example/${attachment.filename}") {
+                if (resume != null) {
+                    header(HttpHeaders.Range, "bytes=${resume.offset}-")
+                    header(HttpHeaders.IfRange, resume.validator)
+                }
+            }.execute { response ->
+                val offset = if (response.status == HttpStatusCode.PartialContent) resume!!.offset else 0L
+                val data =
+                    flow {
+                        val channel = response.bodyAsChannel()
+                        val buffer = ByteArray(4096)
+                        while (true) {
+                            val read = channel.readAvailable(buffer)
+                            if (read == -1) break
+                            emit(buffer.copyOf(read))
+                            bytesReceived.update { it + read }
+                        }
+                    }
+
+                consume(PartialDownload(offset, response.headers[HttpHeaders.ETag], data))
+            }
+    }
+
+    override suspend fun downloadFile(attachment: Attachment): Flow<ByteArray> = throw UnsupportedOperationException("Use downloadFileFrom")
+
+    override suspend fun uploadFile(
+        fileData: Flow<ByteArray>,
+        attachment: Attachment,
+    ) {
+        // No op
+    }
+
+    override suspend fun deleteFile(attachment: Attachment) {
+        // No op
+    }
+}
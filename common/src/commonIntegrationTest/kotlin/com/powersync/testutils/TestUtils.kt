@@ -28,6 +28,7 @@ import kotlinx.coroutines.test.runTest
 import kotlinx.io.files.Path
 import kotlinx.serialization.json.JsonElement
 import kotlin.coroutines.resume
+import kotlin.time.Duration
 
 fun generatePrintLogWriter() =
     object : LogWriter() {
@@ -112,7 +113,10 @@ internal class ActiveDatabaseTest(
         }
     }
 
-    fun openDatabase(schema: Schema = Schema(UserRow.table)): PowerSyncDatabaseImpl {
+    fun openDatabase(
+        schema: Schema = Schema(UserRow.table),
+        groupCommitWindow: Duration = Duration.ZERO,
+    ): PowerSyncDatabaseImpl {
         logger.d { "Opening database $databaseName in directory $testDirectory" }
         val db =
             createPowerSyncDatabaseImpl(
@@ -122,6 +126,7 @@ internal class ActiveDatabaseTest(
                 dbDirectory = testDirectory,
                 logger = logger,
                 scope = scope,
+                groupCommitWindow = groupCommitWindow,
             )
         doOnCleanup { db.close() }
         return db
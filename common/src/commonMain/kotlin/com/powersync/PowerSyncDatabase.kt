@@ -7,8 +7,13 @@ import com.powersync.db.ActiveDatabaseGroup
 import com.powersync.db.ActiveDatabaseResource
 import com.powersync.db.PowerSyncDatabaseImpl
 import com.powersync.db.Queries
+import com.powersync.db.QueryDiff
+import com.powersync.db.RowChangeset
+import com.powersync.db.SqlCursor
 import com.powersync.db.crud.CrudBatch
+import com.powersync.db.crud.CrudEncoding
 import com.powersync.db.crud.CrudTransaction
+import com.powersync.db.crud.EncodedCrudBatch
 import com.powersync.db.driver.SQLiteConnectionPool
 import com.powersync.db.driver.SingleConnectionPool
 import com.powersync.db.schema.Schema
@@ -20,8 +25,10 @@ import com.powersync.utils.generateLogger
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.flow.Flow
 import kotlinx.coroutines.flow.firstOrNull
+import kotlinx.io.Sink
 import kotlin.coroutines.cancellation.CancellationException
 import kotlin.native.HiddenFromObjC
+import kotlin.time.Duration
 
 /**
  * A PowerSync managed database.
@@ -137,6 +144,30 @@ public interface PowerSyncDatabase : Queries {
     @Throws(PowerSyncException::class, CancellationException::class)
     public suspend fun getCrudBatch(limit: Int = 100): CrudBatch?
 
+    /**
+     * Writes a batch of crud data to upload into the [sink] without loading it into memory.
+     *
+     * Unlike [getCrudBatch], this doesn't create [com.powersync.db.crud.CrudEntry] objects for
+     * changes. Instead, the JSON representation of entries stored in the database is copied into
+     * the [sink] directly, either as a JSON array or as newline-delimited JSON objects depending on
+     * the [encoding]. This allows uploading large batches of changes in constant memory.
+     *
+     * When [fields] is set, only those top-level keys (e.g. `op`, `type`, `id` and `data`) are
+     * included in each entry.
+     *
+     * Returns null (without writing anything) if there is no data to upload. Otherwise, call
+     * [EncodedCrudBatch.complete] once the data has been uploaded. The [sink] is not flushed or
+     * closed by this method.
+     */
+    @ExperimentalPowerSyncAPI
+    @Throws(PowerSyncException::class, CancellationException::class)
+    public suspend fun writeCrudBatch(
+        sink: Sink,
+        limit: Int = 100,
+        encoding: CrudEncoding = CrudEncoding.JSON_ARRAY,
+        fields: Set<String>? = null,
+    ): EncodedCrudBatch?
+
     /**
      * Get the next recorded transaction to upload.
      *
@@ -186,6 +217,47 @@ public interface PowerSyncDatabase : Queries {
      */
     public fun getCrudTransactions(): Flow<CrudTransaction>
 
+    /**
+     * Returns a [Flow] of row-level changes made to [tables].
+     *
+     * After each write on the database touching at least one of the [tables], the flow emits a
+     * [RowChangeset] describing the inserted, updated and deleted rows. This allows keeping caches
+     * or search indexes up-to-date incrementally instead of re-running queries on [onChange].
+     *
+     * Changes are recorded with the SQLite session extension, and only while the flow is collected.
+     * This requires a write connection implementing
+     * [com.powersync.db.driver.SessionRecordingConnection], which is the case for connections
+     * opened by the SDK on Kotlin/Native and by the encryption-enabled driver. On other
+     * connections, collecting the flow throws a [PowerSyncException].
+     */
+    @ExperimentalPowerSyncAPI
+    public fun rowChanges(tables: Set<String>): Flow<RowChangeset>
+
+    /**
+     * Like [watch], but emits the changes between consecutive results of the query along with the
+     * complete result.
+     *
+     * Rows are identified across results by the value in their [keyColumn], which must be unique
+     * and not null. Rows are only mapped again when one of their columns has changed, so unchanged
+     * rows are represented by the same instance in all results. This makes it cheap to apply
+     * changes to large lists incrementally.
+     *
+     * @param sql The SQL query to execute.
+     * @param parameters The parameters for the query, or an empty list if none.
+     * @param keyColumn The name of the result column identifying rows, typically `id`.
+     * @param throttleMs The minimum interval, in milliseconds, between queries.
+     * @param mapper A function to map the result set to the desired type.
+     */
+    @ExperimentalPowerSyncAPI
+    @Throws(PowerSyncException::class, CancellationException::class)
+    public fun <RowType : Any> watchDiff(
+        sql: String,
+        parameters: List<Any?>? = listOf(),
+        keyColumn: String = "id",
+        throttleMs: Long = Queries.DEFAULT_THROTTLE.inWholeMilliseconds,
+        mapper: (SqlCursor) -> RowType,
+    ): Flow<QueryDiff<RowType>>
+
     /**
      * Convenience method to get the current version of PowerSync.
      */
@@ -253,6 +325,10 @@ public interface PowerSyncDatabase : Queries {
          * PowerSync SDK will emit a warning if multiple databases are opened with the same
          * identifier, and uses internal locks to ensure these two databases are not synced at the
          * same time (which would be inefficient and can cause consistency issues).
+         *
+         * When [groupCommitWindow] is positive, [execute] calls issued within this window of each
+         * other are committed in a single write transaction, as described for the `PowerSyncDatabase`
+         * factory function.
          */
         public fun opened(
             pool: SQLiteConnectionPool,
@@ -260,9 +336,10 @@ public interface PowerSyncDatabase : Queries {
             schema: Schema,
             identifier: String,
             logger: Logger,
+            groupCommitWindow: Duration = Duration.ZERO,
         ): PowerSyncDatabase {
             val group = ActiveDatabaseGroup.referenceDatabase(logger, identifier)
-            return openedWithGroup(pool, scope, schema, logger, group)
+            return openedWithGroup(pool, scope, schema, logger, group, groupCommitWindow)
         }
 
         /**
@@ -298,6 +375,7 @@ public interface PowerSyncDatabase : Queries {
             schema: Schema,
             logger: Logger,
             group: Pair<ActiveDatabaseResource, Any>,
+            groupCommitWindow: Duration = Duration.ZERO,
         ): PowerSyncDatabase =
             PowerSyncDatabaseImpl(
                 schema,
@@ -305,6 +383,7 @@ public interface PowerSyncDatabase : Queries {
                 pool,
                 logger,
                 group,
+                groupCommitWindow,
             )
     }
 }
@@ -5,11 +5,13 @@ import com.powersync.db.ActiveDatabaseGroup
 import com.powersync.db.PowerSyncDatabaseImpl
 import com.powersync.db.driver.InternalConnectionPool
 import com.powersync.db.driver.LazyPool
+import com.powersync.db.driver.ReadPoolOptions
 import com.powersync.db.schema.Schema
 import com.powersync.utils.generateLogger
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.DelicateCoroutinesApi
 import kotlinx.coroutines.GlobalScope
+import kotlin.time.Duration
 
 public const val DEFAULT_DB_FILENAME: String = "powersync.db"
 
@@ -28,6 +30,19 @@ public fun PowerSyncDatabase(
      * This parameter is ignored for iOS.
      */
     dbDirectory: String? = null,
+    /**
+     * Options for the pool of connections used for reads.
+     */
+    readPoolOptions: ReadPoolOptions = ReadPoolOptions(),
+    /**
+     * When set to a positive duration, [PowerSyncDatabase.execute] calls issued within this window
+     * of each other are committed in a single write transaction. Each statement still fails
+     * independently, but its caller only resumes once the shared transaction has been committed.
+     *
+     * This can speed up workloads issuing many small independent writes concurrently. It is
+     * disabled by default.
+     */
+    groupCommitWindow: Duration = Duration.ZERO,
 ): PowerSyncDatabase {
     val generatedLogger: Logger = generateLogger(logger)
 
@@ -38,6 +53,8 @@ public fun PowerSyncDatabase(
         scope = scope,
         logger = generatedLogger,
         dbDirectory = dbDirectory,
+        readPoolOptions = readPoolOptions,
+        groupCommitWindow = groupCommitWindow,
     )
 }
 
@@ -49,6 +66,8 @@ internal fun createPowerSyncDatabaseImpl(
     scope: CoroutineScope,
     logger: Logger,
     dbDirectory: String?,
+    readPoolOptions: ReadPoolOptions = ReadPoolOptions(),
+    groupCommitWindow: Duration = Duration.ZERO,
 ): PowerSyncDatabaseImpl {
     val identifier = dbDirectory + dbFilename
     val activeDatabaseGroup = ActiveDatabaseGroup.referenceDatabase(logger, identifier)
@@ -61,6 +80,7 @@ internal fun createPowerSyncDatabaseImpl(
                 dbFilename,
                 dbDirectory,
                 activeDatabaseGroup.first.group.writeLockMutex,
+                readPoolOptions,
             )
         }
 
@@ -70,5 +90,6 @@ internal fun createPowerSyncDatabaseImpl(
         schema,
         logger,
         activeDatabaseGroup,
+        groupCommitWindow,
     ) as PowerSyncDatabaseImpl
 }
@@ -63,6 +63,14 @@ public enum class AttachmentState {
  * @property size Size of the attachment in bytes, if available.
  * @property hasSynced Indicates whether the attachment has been synced locally before.
  * @property metaData Additional metadata associated with the attachment.
+ * @property contentHash Hash of the attachment contents, used to share files between attachments
+ * when the content cache of the [AttachmentQueue] is enabled.
+ * @property lastAccessedAt Time of the last recorded access of the attachment, see
+ * [AttachmentQueue.recordAccess].
+ * @property downloadOffset The amount of bytes stored locally by an interrupted download, see
+ * [ResumableRemoteStorage].
+ * @property downloadValidator The version of the remote file the bytes of an interrupted download
+ * belong to.
  */
 public data class Attachment(
     val id: String,
@@ -74,6 +82,10 @@ public data class Attachment(
     val size: Long? = null,
     val hasSynced: Boolean = false,
     val metaData: String? = null,
+    val contentHash: String? = null,
+    val lastAccessedAt: Long? = null,
+    val downloadOffset: Long? = null,
+    val downloadValidator: String? = null,
 ) {
     public companion object {
         /**
@@ -93,6 +105,10 @@ public data class Attachment(
                 state = AttachmentState.fromLong(cursor.getLong("state")),
                 hasSynced = cursor.getLong("has_synced").toInt() > 0,
                 metaData = cursor.getStringOptional("meta_data"),
+                contentHash = cursor.getStringOptional("content_hash"),
+                lastAccessedAt = cursor.getLongOptional("last_accessed_at"),
+                downloadOffset = cursor.getLongOptional("download_offset"),
+                downloadValidator = cursor.getStringOptional("download_validator"),
             )
     }
 }
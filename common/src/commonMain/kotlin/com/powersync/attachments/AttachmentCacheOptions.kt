@@ -0,0 +1,24 @@
+package com.powersync.attachments
+
+/**
+ * Enables content-addressed storage for attachments with a
+ * [content hash][WatchedAttachmentItem.contentHash].
+ *
+ * Attachments with the same hash share a single file, stored under a name derived from the hash.
+ * A new attachment whose contents are already stored locally (including contents of archived
+ * attachments that haven't been evicted yet) is available without downloading it again.
+ *
+ * Archived attachments with a content hash are not limited by the `archivedCacheLimit` of the
+ * [AttachmentQueue]. Instead, once the total size of stored contents exceeds [maxBytes], contents
+ * only referenced by archived attachments are evicted, least recently accessed first.
+ */
+public class AttachmentCacheOptions(
+    /**
+     * The total size of stored contents, in bytes, above which unreferenced contents are evicted.
+     */
+    public val maxBytes: Long,
+) {
+    init {
+        require(maxBytes >= 0) { "maxBytes must not be negative" }
+    }
+}
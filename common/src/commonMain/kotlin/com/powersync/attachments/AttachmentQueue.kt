@@ -3,8 +3,11 @@ package com.powersync.attachments
 import co.touchlab.kermit.Logger
 import com.powersync.PowerSyncDatabase
 import com.powersync.PowerSyncException
+import com.powersync.attachments.implementation.AttachmentContentCache
 import com.powersync.attachments.implementation.AttachmentServiceImpl
+import com.powersync.attachments.implementation.reconcileWatchedAttachments
 import com.powersync.attachments.storage.IOLocalStorageAdapter
+import com.powersync.attachments.sync.AttachmentTransferLimits
 import com.powersync.attachments.sync.SyncingService
 import com.powersync.db.getString
 import com.powersync.db.internal.ConnectionContext
@@ -21,6 +24,7 @@ import kotlinx.coroutines.sync.Mutex
 import kotlinx.coroutines.sync.withLock
 import kotlinx.io.files.Path
 import kotlin.coroutines.cancellation.CancellationException
+import kotlin.time.Clock
 import kotlin.time.Duration
 import kotlin.time.Duration.Companion.seconds
 
@@ -45,6 +49,13 @@ public data class WatchedAttachmentItem(
      * Optional metadata for the attachment record.
      */
     public val metaData: String? = null,
+    /**
+     * Optional hash of the attachment contents, e.g. a SHA-256 digest stored alongside the
+     * attachment reference. When the content cache is enabled, attachments with the same hash
+     * share a single local file. The hash is used in file names, so it may only contain letters,
+     * digits, `-` and `_`.
+     */
+    public val contentHash: String? = null,
 ) {
     init {
         require(fileExtension != null || filename != null) {
@@ -103,7 +114,8 @@ public open class AttachmentQueue(
      */
     public val localStorage: LocalStorage = IOLocalStorageAdapter(),
     /**
-     * SQLite table where attachment state will be recorded.
+     * SQLite table where attachment state will be recorded. The table needs all columns of
+     * [createAttachmentsTable].
      */
     private val attachmentsQueueTableName: String = DEFAULT_TABLE_NAME,
     /**
@@ -141,6 +153,15 @@ public open class AttachmentQueue(
      * Optional scope to launch syncing jobs in.
      */
     private val coroutineScope: CoroutineScope? = null,
+    /**
+     * Limits for concurrent attachment uploads and downloads.
+     */
+    private val transferLimits: AttachmentTransferLimits = AttachmentTransferLimits(),
+    /**
+     * Enables sharing files between attachments with the same
+     * [content hash][WatchedAttachmentItem.contentHash]. Disabled by default.
+     */
+    private val cacheOptions: AttachmentCacheOptions? = null,
 ) {
     public companion object {
         /**
@@ -180,6 +201,18 @@ public open class AttachmentQueue(
     private var syncStatusJob: Job? = null
     private val mutex = Mutex()
 
+    private val contentCache =
+        cacheOptions?.let {
+            AttachmentContentCache(
+                db,
+                attachmentsQueueTableName,
+                localStorage,
+                attachmentsDirectory,
+                it.maxBytes,
+                logger,
+            )
+        }
+
     /**
      * Syncing service for this attachment queue.
      * This processes attachment records and performs relevant upload, download, and delete
@@ -195,6 +228,8 @@ public open class AttachmentQueue(
             logger,
             syncScope,
             syncThrottleDuration,
+            transferLimits,
+            contentCache?.let { it::contentUri },
         )
 
     public var closed: Boolean = false
@@ -222,6 +257,8 @@ public open class AttachmentQueue(
                     localStorage.makeDir(Path(attachmentsDirectory, subdirectory).toString())
                 }
 
+                contentCache?.let { localStorage.makeDir(it.contentDirectory) }
+
                 attachmentsService.withContext { context ->
                     verifyAttachments(context)
                 }
@@ -334,87 +371,18 @@ public open class AttachmentQueue(
                  * We might need to restore an archived attachment.
                  */
                 val currentAttachments = attachmentsContext.getAttachments()
-                val attachmentUpdates = mutableListOf<Attachment>()
-
-                for (item in items) {
-                    val existingQueueItem = currentAttachments.find { it.id == item.id }
-
-                    if (existingQueueItem == null) {
-                        if (!downloadAttachments) {
-                            continue
-                        }
-                        // This item should be added to the queue.
-                        // This item is assumed to be coming from an upstream sync.
-                        // Locally created new items should be persisted using [saveFile] before
-                        // this point.
-                        val filename =
-                            item.filename ?: resolveNewAttachmentFilename(
-                                attachmentId = item.id,
-                                fileExtension = item.fileExtension,
-                            )
-
-                        attachmentUpdates.add(
-                            Attachment(
-                                id = item.id,
-                                filename = filename,
-                                state = AttachmentState.QUEUED_DOWNLOAD,
-                                metaData = item.metaData,
-                            ),
-                        )
-                    } else if (existingQueueItem.state == AttachmentState.ARCHIVED) {
-                        // The attachment is present again. Need to queue it for sync.
-                        // We might be able to optimize this in future.
-                        if (existingQueueItem.hasSynced) {
-                            // No remote action required, we can restore the record (avoids deletion).
-                            attachmentUpdates.add(
-                                existingQueueItem.copy(state = AttachmentState.SYNCED),
-                            )
-                        } else {
-                            /*
-                             * The localURI should be set if the record was meant to be downloaded
-                             * and has been synced. If it's missing and hasSynced is false then
-                             * it must be an upload operation.
-                             */
-                            attachmentUpdates.add(
-                                existingQueueItem.copy(
-                                    state =
-                                        if (existingQueueItem.localUri == null) {
-                                            AttachmentState.QUEUED_DOWNLOAD
-                                        } else {
-                                            AttachmentState.QUEUED_UPLOAD
-                                        },
-                                ),
-                            )
-                        }
-                    }
-                }
-
-                /*
-                 * Archive any items not specified in the watched items.
-                 * For QUEUED_DELETE or QUEUED_UPLOAD states, archive only if hasSynced is true.
-                 * For other states, archive if the record is not found in the items.
-                 */
-                currentAttachments
-                    .filter { attachment ->
-                        val notInWatchedItems =
-                            items.find { update -> update.id == attachment.id } == null
-                        if (notInWatchedItems) {
-                            when (attachment.state) {
-                                // Archive these record if they have synced
-                                AttachmentState.QUEUED_DELETE, AttachmentState.QUEUED_UPLOAD -> attachment.hasSynced
-
-                                // Other states, such as QUEUED_DOWNLOAD can be archived if they are not present in watched items
-                                else -> true
-                            }
-                        } else {
-                            // The record is present in watched items, no need to archive it
-                            false
-                        }
-                    }.forEach {
-                        attachmentUpdates.add(it.copy(state = AttachmentState.ARCHIVED))
-                    }
+                val attachmentUpdates =
+                    reconcileWatchedAttachments(
+                        current = currentAttachments,
+                        items = items,
+                        downloadAttachments = downloadAttachments,
+                        resolveFilename = ::resolveNewAttachmentFilename,
+                        useContentHashes = contentCache != null,
+                    )
 
                 attachmentsContext.saveAttachments(attachmentUpdates)
+                // Archiving attachments may have left contents unreferenced.
+                contentCache?.evict()
             }
         }
 
@@ -516,6 +484,9 @@ public open class AttachmentQueue(
 
     /**
      * Removes all archived items.
+     *
+     * When the content cache is enabled, contents shared by attachments are only removed while
+     * the cache exceeds its size limit, see [AttachmentCacheOptions].
      */
     public suspend fun expireCache() {
         var done: Boolean
@@ -523,9 +494,27 @@ public open class AttachmentQueue(
             do {
                 done = syncingService.deleteArchivedAttachments(context)
             } while (!done)
+
+            contentCache?.evict()
         }
     }
 
+    /**
+     * Records that the attachment with [attachmentId] has been accessed, e.g. because it has been
+     * displayed.
+     *
+     * The content cache evicts contents which haven't been accessed or referenced for the longest
+     * time first. Saving attachment states keeps the recorded access time, so this doesn't have to
+     * wait for a running sync.
+     */
+    @Throws(PowerSyncException::class, CancellationException::class)
+    public suspend fun recordAccess(attachmentId: String) {
+        db.execute(
+            "UPDATE $attachmentsQueueTableName SET last_accessed_at = ? WHERE id = ?",
+            listOf(Clock.System.now().toEpochMilliseconds(), attachmentId),
+        )
+    }
+
     /**
      * Clears the attachment queue and deletes all attachment files.
      */
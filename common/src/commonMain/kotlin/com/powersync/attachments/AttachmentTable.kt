@@ -23,6 +23,10 @@ public fun createAttachmentsTable(name: String): Table =
                 Column("state", ColumnType.INTEGER),
                 Column("has_synced", ColumnType.INTEGER),
                 Column("meta_data", ColumnType.TEXT),
+                Column("content_hash", ColumnType.TEXT),
+                Column("last_accessed_at", ColumnType.INTEGER),
+                Column("download_offset", ColumnType.INTEGER),
+                Column("download_validator", ColumnType.TEXT),
             ),
         localOnly = true,
     )
@@ -93,3 +93,37 @@ public interface LocalStorage {
         targetPath: String,
     ): Unit
 }
+
+/**
+ * A [LocalStorage] able to append data to existing files, which is required to resume downloads
+ * from a [ResumableRemoteStorage].
+ */
+public interface AppendableLocalStorage : LocalStorage {
+    /**
+     * Appends a source of data bytes to the file at a path, creating it if it doesn't exist.
+     *
+     * @param filePath The path of the file to append to.
+     * @param data A [Flow] of [ByteArray] representing the data to append.
+     * @return The amount of bytes appended.
+     * @throws PowerSyncException If an error occurs during the write operation.
+     * @throws CancellationException If the operation is cancelled.
+     */
+    @Throws(PowerSyncException::class, CancellationException::class)
+    public suspend fun appendFile(
+        filePath: String,
+        data: Flow<ByteArray>,
+    ): Long
+
+    /**
+     * Returns the size of the file at a path in bytes, or `null` if it doesn't exist.
+     *
+     * Downloads are only resumed if the partially downloaded file has exactly the size recorded
+     * when the download was interrupted.
+     *
+     * @param filePath The path of the file.
+     * @throws PowerSyncException If an error occurs while reading the file's metadata.
+     * @throws CancellationException If the operation is cancelled.
+     */
+    @Throws(PowerSyncException::class, CancellationException::class)
+    public suspend fun fileSize(filePath: String): Long?
+}
@@ -32,3 +32,58 @@ public interface RemoteStorage {
      */
     public suspend fun deleteFile(attachment: Attachment)
 }
+
+/**
+ * A [RemoteStorage] able to resume interrupted downloads.
+ *
+ * When the [SyncingService][com.powersync.attachments.sync.SyncingService] uses a remote storage
+ * implementing this interface and a [local storage][AppendableLocalStorage] supporting appends,
+ * downloads are started with [downloadFileFrom] instead of [RemoteStorage.downloadFile]. If a
+ * download fails after receiving some data, the amount of bytes stored so far is recorded on the
+ * attachment and the next attempt continues from there.
+ */
+public interface ResumableRemoteStorage : RemoteStorage {
+    /**
+     * Downloads a file from remote storage, continuing a previous download if possible.
+     *
+     * Implementations should request the data starting at [DownloadResumePoint.offset] if [resume]
+     * is set and the file hasn't changed since (for HTTP, this corresponds to `Range` and
+     * `If-Range` headers). [consume] must be called once with the downloaded data. Its
+     * [PartialDownload.offset] is either the requested offset, or `0` if the download had to be
+     * restarted.
+     *
+     * @param attachment The attachment record associated with the file.
+     * @param resume Where to continue a previous download, or `null` to download the whole file.
+     * @param consume Stores the downloaded data.
+     */
+    public suspend fun downloadFileFrom(
+        attachment: Attachment,
+        resume: DownloadResumePoint?,
+        consume: suspend (download: PartialDownload) -> Unit,
+    )
+}
+
+/**
+ * Describes where an interrupted download should continue.
+ *
+ * @property offset The amount of bytes already stored locally.
+ * @property validator An identifier of the file version the stored bytes belong to, e.g. an `ETag`.
+ */
+public data class DownloadResumePoint(
+    public val offset: Long,
+    public val validator: String,
+)
+
+/**
+ * Data received by [ResumableRemoteStorage.downloadFileFrom].
+ *
+ * @property offset The position in the file at which [data] starts.
+ * @property validator An identifier of the downloaded file version (e.g. an `ETag`), required to
+ * resume the download should it fail.
+ * @property data The file data starting at [offset].
+ */
+public class PartialDownload(
+    public val offset: Long,
+    public val validator: String?,
+    public val data: Flow<ByteArray>,
+)
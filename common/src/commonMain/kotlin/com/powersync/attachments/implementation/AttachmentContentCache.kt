@@ -0,0 +1,108 @@
+package com.powersync.attachments.implementation
+
+import co.touchlab.kermit.Logger
+import com.powersync.PowerSyncDatabase
+import com.powersync.attachments.AttachmentState
+import com.powersync.attachments.LocalStorage
+import com.powersync.db.getLong
+import com.powersync.db.getLongOptional
+import com.powersync.db.getString
+import com.powersync.utils.JsonUtil
+import kotlinx.io.files.Path
+
+/**
+ * Manages attachment files stored by their content hash.
+ *
+ * References to a file are not stored separately, they're the attachment records sharing the
+ * `content_hash`. Contents are evicted once only archived records reference them and the total
+ * size of stored contents exceeds [maxBytes].
+ */
+internal class AttachmentContentCache(
+    private val db: PowerSyncDatabase,
+    private val table: String,
+    private val localStorage: LocalStorage,
+    attachmentsDirectory: String,
+    private val maxBytes: Long,
+    private val logger: Logger,
+) {
+    val contentDirectory: String = Path(attachmentsDirectory, CONTENT_DIRECTORY).toString()
+
+    fun contentUri(contentHash: String): String {
+        require(contentHash.isNotEmpty() && contentHash.all { it.isLetterOrDigit() || it == '-' || it == '_' }) {
+            "Invalid content hash: $contentHash"
+        }
+        return Path(contentDirectory, contentHash).toString()
+    }
+
+    /**
+     * Deletes contents only referenced by archived attachments, least recently accessed first,
+     * until the total size of stored contents is within the budget.
+     */
+    suspend fun evict() {
+        val contents =
+            db.getAll(
+                """
+                SELECT
+                    content_hash,
+                    MAX(size) AS size,
+                    MAX(max(timestamp, IFNULL(last_accessed_at, 0))) AS last_access,
+                    SUM(state != ?) AS live_references
+                FROM
+                    $table
+                WHERE
+                    content_hash IS NOT NULL
+                    AND has_synced = 1
+                GROUP BY
+                    content_hash
+                ORDER BY
+                    last_access ASC
+                """,
+                listOf(AttachmentState.ARCHIVED.ordinal),
+            ) {
+                StoredContent(
+                    hash = it.getString("content_hash"),
+                    size = it.getLongOptional("size") ?: 0,
+                    liveReferences = it.getLong("live_references"),
+                )
+            }
+
+        var totalSize = contents.sumOf { it.size }
+        val evicted = mutableListOf<StoredContent>()
+        for (content in contents) {
+            if (totalSize <= maxBytes) break
+            if (content.liveReferences > 0) continue
+
+            evicted.add(content)
+            totalSize -= content.size
+        }
+        if (evicted.isEmpty()) {
+            return
+        }
+
+        logger.v { "Evicting cached attachment contents: $evicted" }
+        // Remove records before files, so that no record references a deleted file.
+        db.execute(
+            "DELETE FROM $table WHERE state = ? AND content_hash IN (SELECT value FROM json_each(?))",
+            listOf(
+                AttachmentState.ARCHIVED.ordinal,
+                JsonUtil.json.encodeToString(evicted.map { it.hash }),
+            ),
+        )
+        for (content in evicted) {
+            val uri = contentUri(content.hash)
+            if (localStorage.fileExists(uri)) {
+                localStorage.deleteFile(uri)
+            }
+        }
+    }
+
+    private data class StoredContent(
+        val hash: String,
+        val size: Long,
+        val liveReferences: Long,
+    )
+
+    private companion object {
+        const val CONTENT_DIRECTORY = "content"
+    }
+}
@@ -147,6 +147,8 @@ public open class AttachmentContextImpl(
                         $table
                     WHERE 
                         state = ?
+                        -- Attachments sharing content are evicted by the content cache instead
+                        AND content_hash IS NULL
                     ORDER BY
                         timestamp DESC
                     LIMIT ? OFFSET ?
@@ -188,12 +190,14 @@ public open class AttachmentContextImpl(
                 timestamp = Clock.System.now().toEpochMilliseconds(),
             )
 
+        // Accesses are recorded outside of the attachment context, so the stored access time may
+        // be newer than the one of the attachment being saved.
         context.execute(
             """
                 INSERT OR REPLACE INTO 
-                    $table (id, timestamp, filename, local_uri, media_type, size, state, has_synced, meta_data) 
+                    $table (id, timestamp, filename, local_uri, media_type, size, state, has_synced, meta_data, content_hash, last_accessed_at, download_offset, download_validator) 
                 VALUES
-                    (?, ?, ?, ?, ?, ?, ?, ?, ?)
+                    (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, IFNULL((SELECT last_accessed_at FROM $table WHERE id = ?), ?), ?, ?)
             """,
             listOf(
                 updatedRecord.id,
@@ -205,6 +209,11 @@ public open class AttachmentContextImpl(
                 updatedRecord.state.ordinal,
                 if (updatedRecord.hasSynced) 1 else 0,
                 updatedRecord.metaData,
+                updatedRecord.contentHash,
+                updatedRecord.id,
+                updatedRecord.lastAccessedAt,
+                updatedRecord.downloadOffset,
+                updatedRecord.downloadValidator,
             ),
         )
 
@@ -0,0 +1,134 @@
+package com.powersync.attachments.implementation
+
+import com.powersync.attachments.Attachment
+import com.powersync.attachments.AttachmentState
+import com.powersync.attachments.WatchedAttachmentItem
+
+/**
+ * Computes the attachment records to save so that the attachment queue reflects the watched
+ * [items], given the [current] records of the queue.
+ *
+ * Both lists are indexed by id once, so this runs in time linear to their sizes. Only records
+ * whose state changes are returned.
+ *
+ * With [useContentHashes], new attachments record the content hash of their item. If the contents
+ * are already stored for another attachment, the new attachment references the same file instead
+ * of being queued for download.
+ */
+internal suspend fun reconcileWatchedAttachments(
+    current: List<Attachment>,
+    items: List<WatchedAttachmentItem>,
+    downloadAttachments: Boolean,
+    resolveFilename: suspend (attachmentId: String, fileExtension: String?) -> String,
+    useContentHashes: Boolean = false,
+): List<Attachment> {
+    val currentById = current.associateBy { it.id }
+    val storedContents =
+        if (useContentHashes) {
+            current
+                .filter {
+                    it.contentHash != null &&
+                        it.localUri != null &&
+                        it.hasSynced &&
+                        (it.state == AttachmentState.SYNCED || it.state == AttachmentState.ARCHIVED)
+                }.associateBy { it.contentHash }
+        } else {
+            emptyMap()
+        }
+    val watchedIds = HashSet<String>(items.size)
+    val updates = mutableListOf<Attachment>()
+
+    for (item in items) {
+        if (!watchedIds.add(item.id)) {
+            // Duplicate items reference the same attachment.
+            continue
+        }
+
+        val existingQueueItem = currentById[item.id]
+        if (existingQueueItem == null) {
+            if (!downloadAttachments) {
+                continue
+            }
+            // This item should be added to the queue.
+            // This item is assumed to be coming from an upstream sync.
+            // Locally created new items should be persisted using saveFile before this point.
+            val filename = item.filename ?: resolveFilename(item.id, item.fileExtension)
+            val contentHash = item.contentHash?.takeIf { useContentHashes }
+            val storedContent = contentHash?.let { storedContents[it] }
+
+            updates.add(
+                if (storedContent != null) {
+                    // The contents are available locally, no need to download them.
+                    Attachment(
+                        id = item.id,
+                        filename = filename,
+                        state = AttachmentState.SYNCED,
+                        localUri = storedContent.localUri,
+                        mediaType = storedContent.mediaType,
+                        size = storedContent.size,
+                        hasSynced = true,
+                        metaData = item.metaData,
+                        contentHash = contentHash,
+                    )
+                } else {
+                    Attachment(
+                        id = item.id,
+                        filename = filename,
+                        state = AttachmentState.QUEUED_DOWNLOAD,
+                        metaData = item.metaData,
+                        contentHash = contentHash,
+                    )
+                },
+            )
+        } else if (existingQueueItem.state == AttachmentState.ARCHIVED) {
+            // The attachment is present again. Need to queue it for sync.
+            if (existingQueueItem.hasSynced) {
+                // No remote action required, we can restore the record (avoids deletion).
+                updates.add(existingQueueItem.copy(state = AttachmentState.SYNCED))
+            } else {
+                /*
+                 * The localURI should be set if the record was meant to be downloaded
+                 * and has been synced. If it's missing and hasSynced is false then
+                 * it must be an upload operation.
+                 */
+                updates.add(
+                    existingQueueItem.copy(
+                        state =
+                            if (existingQueueItem.localUri == null) {
+                                AttachmentState.QUEUED_DOWNLOAD
+                            } else {
+                                AttachmentState.QUEUED_UPLOAD
+                            },
+                    ),
+                )
+            }
+        }
+    }
+
+    /*
+     * Archive any items not specified in the watched items.
+     * For QUEUED_DELETE or QUEUED_UPLOAD states, archive only if hasSynced is true.
+     * For other states, archive if the record is not found in the items.
+     */
+    for (attachment in current) {
+        if (attachment.id in watchedIds) {
+            // The record is present in watched items, no need to archive it
+            continue
+        }
+
+        val archive =
+            when (attachment.state) {
+                // Archive these record if they have synced
+                AttachmentState.QUEUED_DELETE, AttachmentState.QUEUED_UPLOAD -> attachment.hasSynced
+                // Already archived
+                AttachmentState.ARCHIVED -> false
+                // Other states, such as QUEUED_DOWNLOAD can be archived if they are not present in watched items
+                else -> true
+            }
+        if (archive) {
+            updates.add(attachment.copy(state = AttachmentState.ARCHIVED))
+        }
+    }
+
+    return updates
+}
@@ -1,8 +1,7 @@
 package com.powersync.attachments.storage
 
-import com.powersync.attachments.LocalStorage
+import com.powersync.attachments.AppendableLocalStorage
 import com.powersync.db.runWrapped
-import io.ktor.utils.io.core.remaining
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.IO
 import kotlinx.coroutines.flow.Flow
@@ -14,30 +13,52 @@ import kotlinx.io.buffered
 import kotlinx.io.files.FileSystem
 import kotlinx.io.files.Path
 import kotlinx.io.files.SystemFileSystem
-import kotlinx.io.readByteArray
+import kotlinx.io.unsafe.UnsafeBufferOperations
+import kotlinx.io.unsafe.UnsafeIoApi
 
 /**
  * Storage adapter for local storage using the KotlinX IO library
+ *
+ * @param readChunkSize The size of chunks emitted by [readFile], in bytes. Only the last chunk of
+ * a file may be smaller.
  */
+@OptIn(UnsafeIoApi::class)
 public open class IOLocalStorageAdapter(
     private val fileSystem: FileSystem = SystemFileSystem,
-) : LocalStorage {
+    private val readChunkSize: Int = DEFAULT_READ_CHUNK_SIZE,
+) : AppendableLocalStorage {
+    init {
+        require(readChunkSize > 0) { "readChunkSize must be positive" }
+    }
+
     public override suspend fun saveFile(
         filePath: String,
         data: Flow<ByteArray>,
+    ): Long = writeFile(filePath, data, append = false)
+
+    public override suspend fun appendFile(
+        filePath: String,
+        data: Flow<ByteArray>,
+    ): Long = writeFile(filePath, data, append = true)
+
+    private suspend fun writeFile(
+        filePath: String,
+        data: Flow<ByteArray>,
+        append: Boolean,
     ): Long =
         runWrapped {
             withContext(Dispatchers.IO) {
                 var totalSize = 0L
-                fileSystem.sink(Path(filePath)).use { sink ->
-                    // Copy to a buffer in order to write
+                fileSystem.sink(Path(filePath), append).use { sink ->
                     Buffer().use { buffer ->
                         data.collect { chunk ->
-                            // Copy into a buffer in order to sink the chunk
-                            buffer.write(chunk, 0)
-                            val chunkSize = chunk.size.toLong()
-                            totalSize += chunkSize
-                            sink.write(buffer, chunkSize)
+                            if (chunk.isEmpty()) return@collect
+
+                            // Hand the chunk to the buffer as a segment instead of copying it. The
+                            // sink consumes the buffer before the chunk could be reused.
+                            UnsafeBufferOperations.moveToTail(buffer, chunk)
+                            totalSize += chunk.size
+                            sink.write(buffer, buffer.size)
                         }
                     }
                     sink.flush()
@@ -51,15 +72,19 @@ public open class IOLocalStorageAdapter(
         mediaType: String?,
     ): Flow<ByteArray> =
         flow {
-            fileSystem.source(Path(filePath)).use { source ->
-                source.buffered().use { bufferedSource ->
-                    var remaining = 0L
-                    val bufferSize = 8192L
-                    do {
-                        bufferedSource.request(bufferSize)
-                        remaining = bufferedSource.remaining
-                        emit(bufferedSource.readByteArray(remaining.toInt()))
-                    } while (remaining > 0)
+            fileSystem.source(Path(filePath)).buffered().use { source ->
+                // Chunks are filled straight from the (pooled) segments of the source, so each
+                // byte is copied once into the array emitted for it.
+                while (!source.exhausted()) {
+                    val chunk = ByteArray(readChunkSize)
+                    var filled = 0
+                    while (filled < chunk.size) {
+                        val read = source.readAtMostTo(chunk, filled, chunk.size)
+                        if (read == -1) break
+                        filled += read
+                    }
+
+                    emit(if (filled == chunk.size) chunk else chunk.copyOf(filled))
                 }
             }
         }.flowOn(Dispatchers.IO)
@@ -78,6 +103,13 @@ public open class IOLocalStorageAdapter(
             }
         }
 
+    public override suspend fun fileSize(filePath: String): Long? =
+        runWrapped {
+            withContext(Dispatchers.IO) {
+                fileSystem.metadataOrNull(Path(filePath))?.takeIf { it.isRegularFile }?.size
+            }
+        }
+
     public override suspend fun makeDir(path: String): Unit =
         runWrapped {
             withContext(Dispatchers.IO) {
@@ -114,4 +146,11 @@ public open class IOLocalStorageAdapter(
                 }
             }
         }
+
+    public companion object {
+        /**
+         * The default size of chunks emitted by [readFile].
+         */
+        public const val DEFAULT_READ_CHUNK_SIZE: Int = 64 * 1024
+    }
 }
@@ -0,0 +1,49 @@
+package com.powersync.attachments.sync
+
+/**
+ * Limits applied by [SyncingService] when transferring attachments.
+ *
+ * Pending transfers are started with the most recently referenced attachments first, and run
+ * concurrently as long as these limits allow it.
+ */
+public data class AttachmentTransferLimits(
+    /**
+     * The maximum amount of downloads running at the same time.
+     */
+    public val maxConcurrentDownloads: Int = 4,
+    /**
+     * The maximum amount of uploads and remote deletes running at the same time.
+     */
+    public val maxConcurrentUploads: Int = 2,
+    /**
+     * The maximum total [size][com.powersync.attachments.Attachment.size] of attachments being
+     * transferred at the same time, in bytes.
+     *
+     * Attachments with an unknown size, such as downloads that haven't completed before, count as
+     * [unknownSizeEstimate] bytes. An attachment larger than the budget is transferred once no
+     * other transfers counting towards the budget are running.
+     */
+    public val maxInFlightBytes: Long = DEFAULT_MAX_IN_FLIGHT_BYTES,
+    /**
+     * The amount of bytes reserved in [maxInFlightBytes] for attachments with an unknown size.
+     */
+    public val unknownSizeEstimate: Long = DEFAULT_UNKNOWN_SIZE_ESTIMATE,
+) {
+    init {
+        require(maxConcurrentDownloads >= 1) { "maxConcurrentDownloads must be at least 1" }
+        require(maxConcurrentUploads >= 1) { "maxConcurrentUploads must be at least 1" }
+        require(maxInFlightBytes > 0) { "maxInFlightBytes must be positive" }
+        require(unknownSizeEstimate > 0) { "unknownSizeEstimate must be positive" }
+    }
+
+    public companion object {
+        public const val DEFAULT_MAX_IN_FLIGHT_BYTES: Long = 64L * 1024 * 1024
+        public const val DEFAULT_UNKNOWN_SIZE_ESTIMATE: Long = 1L * 1024 * 1024
+
+        /**
+         * Limits transferring one attachment at a time.
+         */
+        public val SEQUENTIAL: AttachmentTransferLimits =
+            AttachmentTransferLimits(maxConcurrentDownloads = 1, maxConcurrentUploads = 1)
+    }
+}
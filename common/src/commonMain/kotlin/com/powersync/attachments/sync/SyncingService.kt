@@ -2,12 +2,15 @@ package com.powersync.attachments.sync
 
 import co.touchlab.kermit.Logger
 import com.powersync.PowerSyncException
+import com.powersync.attachments.AppendableLocalStorage
 import com.powersync.attachments.Attachment
 import com.powersync.attachments.AttachmentContext
 import com.powersync.attachments.AttachmentService
 import com.powersync.attachments.AttachmentState
+import com.powersync.attachments.DownloadResumePoint
 import com.powersync.attachments.LocalStorage
 import com.powersync.attachments.RemoteStorage
+import com.powersync.attachments.ResumableRemoteStorage
 import com.powersync.attachments.SyncErrorHandler
 import com.powersync.utils.throttle
 import kotlinx.coroutines.CancellationException
@@ -15,13 +18,19 @@ import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Job
 import kotlinx.coroutines.cancelAndJoin
 import kotlinx.coroutines.channels.BufferOverflow
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.channels.SendChannel
+import kotlinx.coroutines.coroutineScope
 import kotlinx.coroutines.delay
 import kotlinx.coroutines.flow.MutableSharedFlow
 import kotlinx.coroutines.flow.asSharedFlow
 import kotlinx.coroutines.flow.buffer
+import kotlinx.coroutines.flow.flow
 import kotlinx.coroutines.flow.merge
+import kotlinx.coroutines.joinAll
 import kotlinx.coroutines.launch
 import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.Semaphore
 import kotlinx.coroutines.sync.withLock
 import kotlin.time.Duration
 import kotlin.time.Duration.Companion.seconds
@@ -44,6 +53,9 @@ import kotlin.time.Duration.Companion.seconds
  * @property logger Logger instance for logging sync operations and errors.
  * @property syncThrottle The minimum duration between consecutive sync operations.
  * @property scope The coroutine scope used for managing sync operations.
+ * @property transferLimits Limits for concurrent uploads, downloads and in-flight bytes.
+ * @property getContentUri Optionally resolves the local URI for attachments with a content hash.
+ * Attachments sharing a hash are downloaded once and share their local file.
  */
 public open class SyncingService(
     private val remoteStorage: RemoteStorage,
@@ -54,8 +66,13 @@ public open class SyncingService(
     private val logger: Logger,
     private val scope: CoroutineScope,
     private val syncThrottle: Duration = 5.seconds,
+    private val transferLimits: AttachmentTransferLimits = AttachmentTransferLimits(),
+    private val getContentUri: ((contentHash: String) -> String)? = null,
 ) {
     private val mutex = Mutex()
+    private val downloadPermits = Semaphore(transferLimits.maxConcurrentDownloads)
+    private val uploadPermits = Semaphore(transferLimits.maxConcurrentUploads)
+    private val byteBudget = TransferBudget(transferLimits.maxInFlightBytes)
     private var syncJob: Job? = null
 
     /**
@@ -151,6 +168,10 @@ public open class SyncingService(
      * Handles syncing operations for a list of attachments, including downloading,
      * uploading, and deleting files based on their states.
      *
+     * Transfers run concurrently within the [transferLimits], starting with the most recently
+     * referenced attachments. Updated states are saved in batches as transfers complete, so that
+     * a failure or cancellation doesn't lose the progress of completed transfers.
+     *
      * @param attachments The list of attachments to process.
      * @param context The attachment context used for managing attachment states.
      */
@@ -158,39 +179,126 @@ public open class SyncingService(
         attachments: List<Attachment>,
         context: AttachmentContext,
     ) {
-        val updatedAttachments = mutableListOf<Attachment>()
-        try {
-            for (attachment in attachments) {
-                when (attachment.state) {
-                    AttachmentState.QUEUED_DOWNLOAD -> {
-                        logger.i("Downloading ${attachment.filename}")
-                        updatedAttachments.add(downloadAttachment(attachment))
-                    }
+        val byPriority = attachments.sortedByDescending { it.timestamp }
+        // Attachments sharing their contents only need to be downloaded once.
+        val downloads =
+            byPriority
+                .filter { it.state == AttachmentState.QUEUED_DOWNLOAD }
+                .groupBy { attachment -> sharedContentUri(attachment) ?: attachment.id }
+                .values
+        // Deletes are remote mutations as well, so they share the upload limit.
+        val uploads =
+            byPriority
+                .filter {
+                    it.state == AttachmentState.QUEUED_UPLOAD || it.state == AttachmentState.QUEUED_DELETE
+                }.map { listOf(it) }
+        if (downloads.isEmpty() && uploads.isEmpty()) {
+            return
+        }
 
-                    AttachmentState.QUEUED_UPLOAD -> {
-                        logger.i("Uploading ${attachment.filename}")
-                        updatedAttachments.add(uploadAttachment(attachment))
-                    }
+        try {
+            coroutineScope {
+                val completed = Channel<Attachment>(Channel.UNLIMITED)
+                val saver =
+                    launch {
+                        for (first in completed) {
+                            val batch = mutableListOf(first)
+                            while (true) {
+                                batch.add(completed.tryReceive().getOrNull() ?: break)
+                            }
 
-                    AttachmentState.QUEUED_DELETE -> {
-                        logger.i("Deleting ${attachment.filename}")
-                        updatedAttachments.add(deleteAttachment(attachment))
+                            // Update the state of processed attachments
+                            context.saveAttachments(batch)
+                        }
                     }
 
-                    AttachmentState.SYNCED -> {}
+                listOf(
+                    launch { startTransfers(downloads, downloadPermits, completed) },
+                    launch { startTransfers(uploads, uploadPermits, completed) },
+                ).joinAll()
 
-                    AttachmentState.ARCHIVED -> {}
-                }
+                completed.close()
+                saver.join()
             }
-
-            // Update the state of processed attachments
-            context.saveAttachments(updatedAttachments)
         } catch (error: Exception) {
+            if (error is CancellationException) {
+                throw error
+            }
             // We retry, on the next invocation, whenever there are errors on this level
             logger.e("Error during sync: ${error.message}")
         }
     }
 
+    /**
+     * Starts transfers for [groups] in order, waiting for a permit and for room in the byte
+     * budget before each one. Updated attachments are sent to [completed].
+     *
+     * Each group consists of attachments sharing their contents, only the first one is
+     * transferred.
+     */
+    private suspend fun CoroutineScope.startTransfers(
+        groups: Collection<List<Attachment>>,
+        permits: Semaphore,
+        completed: SendChannel<Attachment>,
+    ) {
+        for (group in groups) {
+            val attachment = group.first()
+            val bytes = attachment.size ?: transferLimits.unknownSizeEstimate
+            permits.acquire()
+            try {
+                byteBudget.acquire(bytes)
+            } catch (e: CancellationException) {
+                permits.release()
+                throw e
+            }
+
+            launch {
+                try {
+                    val result = transfer(attachment)
+                    completed.send(result)
+                    for (other in group.drop(1)) {
+                        completed.send(
+                            if (result.state == AttachmentState.SYNCED) {
+                                other.copy(
+                                    state = AttachmentState.SYNCED,
+                                    localUri = result.localUri,
+                                    size = result.size,
+                                    hasSynced = true,
+                                )
+                            } else {
+                                // Try again in the next sync iteration.
+                                other
+                            },
+                        )
+                    }
+                } finally {
+                    byteBudget.release(bytes)
+                    permits.release()
+                }
+            }
+        }
+    }
+
+    private suspend fun transfer(attachment: Attachment): Attachment =
+        when (attachment.state) {
+            AttachmentState.QUEUED_DOWNLOAD -> {
+                logger.i("Downloading ${attachment.filename}")
+                downloadAttachment(attachment)
+            }
+
+            AttachmentState.QUEUED_UPLOAD -> {
+                logger.i("Uploading ${attachment.filename}")
+                uploadAttachment(attachment)
+            }
+
+            AttachmentState.QUEUED_DELETE -> {
+                logger.i("Deleting ${attachment.filename}")
+                deleteAttachment(attachment)
+            }
+
+            AttachmentState.SYNCED, AttachmentState.ARCHIVED -> attachment
+        }
+
     /**
      * Uploads an attachment from local storage to remote storage.
      *
@@ -238,32 +346,106 @@ public open class SyncingService(
          * When downloading an attachment we take the filename and resolve
          * the local_uri where the file will be stored
          */
-        val attachmentPath = getLocalUri(attachment.filename)
+        val attachmentPath = sharedContentUri(attachment) ?: getLocalUri(attachment.filename)
+        // Bytes stored by a resumable download, kept if the download fails.
+        var progress: DownloadResumePoint? = null
 
         try {
-            val fileFlow = remoteStorage.downloadFile(attachment)
-            localStorage.saveFile(attachmentPath, fileFlow)
+            val size =
+                if (remoteStorage is ResumableRemoteStorage && localStorage is AppendableLocalStorage) {
+                    downloadResumable(remoteStorage, localStorage, attachment, attachmentPath) {
+                        progress = it
+                    }
+                } else {
+                    val fileFlow = remoteStorage.downloadFile(attachment)
+                    localStorage.saveFile(attachmentPath, fileFlow)
+                }
             logger.i("Downloaded file \"${attachment.id}\"")
 
             // The attachment has been downloaded locally
             return attachment.copy(
                 localUri = attachmentPath,
+                size = size,
                 state = AttachmentState.SYNCED,
                 hasSynced = true,
+                downloadOffset = null,
+                downloadValidator = null,
             )
         } catch (e: Exception) {
+            val failed =
+                attachment.copy(
+                    downloadOffset = progress?.offset,
+                    downloadValidator = progress?.validator,
+                )
             if (errorHandler != null) {
                 val shouldRetry = errorHandler.onDownloadError(attachment, e)
                 if (!shouldRetry) {
                     logger.i("Attachment with ID ${attachment.id} has been archived")
-                    return attachment.copy(state = AttachmentState.ARCHIVED)
+                    return failed.copy(state = AttachmentState.ARCHIVED)
                 }
             }
 
             logger.e("Download attachment error for attachment $attachment: ${e.message}")
             // Return the same state, this will cause a retry
-            return attachment
+            return failed
+        }
+    }
+
+    /**
+     * Downloads an attachment from a [ResumableRemoteStorage], appending to the bytes stored by a
+     * previous attempt if possible.
+     *
+     * [onProgress] is called with the point to resume from after each chunk has been stored.
+     *
+     * @return The size of the downloaded file.
+     */
+    private suspend fun downloadResumable(
+        remote: ResumableRemoteStorage,
+        local: AppendableLocalStorage,
+        attachment: Attachment,
+        path: String,
+        onProgress: (DownloadResumePoint?) -> Unit,
+    ): Long {
+        val offset = attachment.downloadOffset
+        val validator = attachment.downloadValidator
+        // Writes after the recorded offset may have been interrupted, in which case the file can't
+        // be appended to and the download starts over.
+        val resume =
+            if (offset != null && offset > 0 && validator != null && local.fileSize(path) == offset) {
+                DownloadResumePoint(offset, validator)
+            } else {
+                null
+            }
+        onProgress(resume)
+
+        var size = 0L
+        remote.downloadFileFrom(attachment, resume) { download ->
+            if (download.offset != 0L && download.offset != resume?.offset) {
+                throw PowerSyncException(
+                    "Download of ${attachment.id} started at unexpected offset ${download.offset}",
+                    cause = null,
+                )
+            }
+
+            size = download.offset
+            onProgress(resume.takeIf { download.offset > 0 })
+            val data =
+                flow {
+                    download.data.collect { chunk ->
+                        emit(chunk)
+                        // The chunk has been stored once emit returns.
+                        size += chunk.size
+                        onProgress(download.validator?.let { DownloadResumePoint(size, it) })
+                    }
+                }
+
+            if (download.offset > 0) {
+                local.appendFile(path, data)
+            } else {
+                local.saveFile(path, data)
+            }
         }
+        return size
     }
 
     /**
@@ -275,7 +457,11 @@ public open class SyncingService(
     private suspend fun deleteAttachment(attachment: Attachment): Attachment {
         try {
             remoteStorage.deleteFile(attachment)
-            if (attachment.localUri != null && localStorage.fileExists(attachment.localUri)) {
+            // Shared contents are deleted once they're no longer referenced.
+            if (sharedContentUri(attachment) == null &&
+                attachment.localUri != null &&
+                localStorage.fileExists(attachment.localUri)
+            ) {
                 localStorage.deleteFile(attachment.localUri)
             }
             return attachment.copy(state = AttachmentState.ARCHIVED)
@@ -293,6 +479,9 @@ public open class SyncingService(
         }
     }
 
+    private fun sharedContentUri(attachment: Attachment): String? =
+        attachment.contentHash?.let { hash -> getContentUri?.invoke(hash) }
+
     /**
      * Deletes archived attachments from local storage.
      *
@@ -0,0 +1,32 @@
+package com.powersync.attachments.sync
+
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.first
+import kotlinx.coroutines.flow.update
+
+/**
+ * Tracks the amount of bytes being transferred, suspending new transfers while they would exceed
+ * [maxBytes].
+ */
+internal class TransferBudget(
+    private val maxBytes: Long,
+) {
+    private val inFlight = MutableStateFlow(0L)
+
+    suspend fun acquire(bytes: Long) {
+        if (bytes <= 0) return
+
+        while (true) {
+            // A transfer larger than the budget may run once it's the only one.
+            val current = inFlight.first { it == 0L || it + bytes <= maxBytes }
+            if (inFlight.compareAndSet(current, current + bytes)) {
+                return
+            }
+        }
+    }
+
+    fun release(bytes: Long) {
+        if (bytes <= 0) return
+        inFlight.update { it - bytes }
+    }
+}
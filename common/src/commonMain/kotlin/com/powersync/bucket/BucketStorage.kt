@@ -10,6 +10,7 @@ import com.powersync.utils.JsonUtil
 import kotlinx.serialization.SerialName
 import kotlinx.serialization.Serializable
 import kotlinx.serialization.json.JsonObject
+import kotlin.time.Duration
 
 internal interface BucketStorage {
     fun getMaxOpId(): String
@@ -31,14 +32,42 @@ internal interface BucketStorage {
     suspend fun hasCompletedSync(): Boolean
 
     suspend fun control(args: PowerSyncControlArguments): List<Instruction>
+
+    /**
+     * Invokes `powersync_control` for a prefix of [args] in a single write transaction.
+     *
+     * Processing stops early after an invocation returning an instruction that affects how
+     * subsequent lines must be handled (see [Instruction.endsControlBatch]), or once [maxDuration]
+     * has passed. The result reports how many arguments have been processed, the caller is
+     * responsible for handling the rest.
+     */
+    suspend fun controlBatch(
+        args: List<PowerSyncControlArguments>,
+        maxDuration: Duration,
+    ): ControlBatchResult
 }
 
+internal class ControlBatchResult(
+    /**
+     * Instructions returned by all processed invocations, with superseded
+     * [Instruction.UpdateSyncStatus] instructions removed.
+     */
+    val instructions: List<Instruction>,
+    val processed: Int,
+)
+
 internal sealed interface PowerSyncControlArguments {
     /**
      * Returns the arguments for the `powersync_control` SQL invocation.
      */
     val sqlArguments: Pair<String, Any?>
 
+    /**
+     * The statement invoking `powersync_control` with [sqlArguments].
+     */
+    val sql: String
+        get() = "SELECT powersync_control(?, ?) AS r"
+
     @Serializable
     class Start(
         val parameters: JsonObject,
@@ -64,8 +93,25 @@ internal sealed interface PowerSyncControlArguments {
         override val sqlArguments: Pair<String, Any?> = "line_text" to line
     }
 
+    /**
+     * A JSON sync line passed as UTF-8 bytes.
+     *
+     * The bytes are bound as a blob and reinterpreted as text in SQL, which avoids decoding the
+     * line into a [String] just for it to be encoded as UTF-8 again when binding it.
+     */
+    class Utf8TextLine(
+        val line: ByteArray,
+    ) : PowerSyncControlArguments {
+        override fun toString(): String = "Utf8TextLine"
+
+        override val sqlArguments: Pair<String, Any?> = "line_text" to line
+
+        override val sql: String
+            get() = "SELECT powersync_control(?, CAST(? AS TEXT)) AS r"
+    }
+
     class BinaryLine(
-        line: ByteArray,
+        val line: ByteArray,
     ) : PowerSyncControlArguments {
         override fun toString(): String = "BinaryLine"
 
@@ -88,6 +134,19 @@ internal sealed interface PowerSyncControlArguments {
         override val sqlArguments: Pair<String, Any?> = "connection" to "end"
     }
 
+    /**
+     * The approximate size of sync lines received from the service, or `null` for arguments not
+     * representing a sync line.
+     */
+    val syncLineSize: Int?
+        get() =
+            when (this) {
+                is TextLine -> line.length
+                is Utf8TextLine -> line.size
+                is BinaryLine -> line.size
+                else -> null
+            }
+
     class UpdateSubscriptions(
         activeStreams: List<StreamKey>,
     ) : PowerSyncControlArguments {
@@ -9,7 +9,10 @@ import com.powersync.db.internal.InternalDatabase
 import com.powersync.db.internal.InternalTable
 import com.powersync.db.internal.PowerSyncTransaction
 import com.powersync.sync.Instruction
-import com.powersync.utils.JsonUtil
+import com.powersync.sync.coalesceStatusUpdates
+import com.powersync.sync.decodeInstructions
+import kotlin.time.Duration
+import kotlin.time.TimeSource
 
 internal class BucketStorageImpl(
     private val db: InternalDatabase,
@@ -134,7 +137,7 @@ internal class BucketStorageImpl(
         val result = cursor.getString(0)!!
         logger.v { "control result: $result" }
 
-        return JsonUtil.json.decodeFromString<List<Instruction>>(result)
+        return decodeInstructions(result)
     }
 
     override suspend fun control(args: PowerSyncControlArguments): List<Instruction> =
@@ -142,6 +145,32 @@ internal class BucketStorageImpl(
             logger.v { "powersync_control: $args" }
 
             val (op: String, data: Any?) = args.sqlArguments
-            tx.get("SELECT powersync_control(?, ?) AS r", listOf(op, data), ::handleControlResult)
+            tx.get(args.sql, listOf(op, data), ::handleControlResult)
+        }
+
+    override suspend fun controlBatch(
+        args: List<PowerSyncControlArguments>,
+        maxDuration: Duration,
+    ): ControlBatchResult =
+        db.writeTransaction { tx ->
+            val started = TimeSource.Monotonic.markNow()
+            val instructions = mutableListOf<Instruction>()
+            var processed = 0
+
+            for (arg in args) {
+                logger.v { "powersync_control: $arg" }
+
+                val (op: String, data: Any?) = arg.sqlArguments
+                val result = tx.get(arg.sql, listOf(op, data), ::handleControlResult)
+                instructions.addAll(result)
+                processed++
+
+                if (result.any { it.endsControlBatch } || started.elapsedNow() >= maxDuration) {
+                    break
+                }
+            }
+
+            logger.v { "powersync_control: Applied $processed lines in a single transaction" }
+            ControlBatchResult(instructions.coalesceStatusUpdates(), processed)
         }
 }
@@ -9,9 +9,12 @@ import com.powersync.bucket.BucketStorageImpl
 import com.powersync.bucket.StreamPriority
 import com.powersync.connectors.PowerSyncBackendConnector
 import com.powersync.db.crud.CrudBatch
+import com.powersync.db.crud.CrudBatchEncoder
+import com.powersync.db.crud.CrudEncoding
 import com.powersync.db.crud.CrudEntry
 import com.powersync.db.crud.CrudRow
 import com.powersync.db.crud.CrudTransaction
+import com.powersync.db.crud.EncodedCrudBatch
 import com.powersync.db.driver.SQLiteConnectionLease
 import com.powersync.db.driver.SQLiteConnectionPool
 import com.powersync.db.internal.InternalDatabaseImpl
@@ -46,6 +49,8 @@ import kotlinx.coroutines.launch
 import kotlinx.coroutines.supervisorScope
 import kotlinx.coroutines.sync.Mutex
 import kotlinx.coroutines.sync.withLock
+import kotlinx.io.Sink
+import kotlin.time.Duration
 import kotlin.time.Duration.Companion.milliseconds
 
 /**
@@ -64,6 +69,7 @@ internal class PowerSyncDatabaseImpl(
     pool: SQLiteConnectionPool,
     val logger: Logger,
     private val activeDatabaseGroup: Pair<ActiveDatabaseResource, Any>,
+    groupCommitWindow: Duration = Duration.ZERO,
 ) : PowerSyncDatabase {
     companion object {
         internal val streamConflictMessage =
@@ -82,7 +88,7 @@ internal class PowerSyncDatabaseImpl(
     private val resource = activeDatabaseGroup.first
     private val streams = StreamTracker(this)
 
-    private val internalDb = InternalDatabaseImpl(pool, logger)
+    private val internalDb = InternalDatabaseImpl(pool, logger, scope, groupCommitWindow)
 
     internal val bucketStorage: BucketStorage = BucketStorageImpl(internalDb, logger)
 
@@ -155,7 +161,7 @@ internal class PowerSyncDatabaseImpl(
         mutex.withLock {
             disconnectInternal()
 
-            connectInternal(crudThrottleMs) { scope ->
+            connectInternal(crudThrottleMs, options.statusUpdateInterval) { scope ->
                 StreamingSyncClient(
                     bucketStorage = bucketStorage,
                     connector = connector,
@@ -175,6 +181,7 @@ internal class PowerSyncDatabaseImpl(
 
     private fun connectInternal(
         crudThrottleMs: Long,
+        statusUpdateInterval: Duration,
         createStream: (CoroutineScope) -> StreamingSyncClient,
     ) {
         val db = this
@@ -223,7 +230,7 @@ internal class PowerSyncDatabaseImpl(
             }
 
             launch {
-                currentStatus.trackOther(stream.status)
+                currentStatus.trackOther(stream.status, statusUpdateInterval)
             }
 
             launch {
@@ -278,6 +285,30 @@ internal class PowerSyncDatabaseImpl(
         })
     }
 
+    override suspend fun writeCrudBatch(
+        sink: Sink,
+        limit: Int,
+        encoding: CrudEncoding,
+        fields: Set<String>?,
+    ): EncodedCrudBatch? {
+        waitReady()
+        if (!bucketStorage.hasCrud()) {
+            return null
+        }
+
+        val encoder = CrudBatchEncoder(encoding, fields)
+        val result =
+            runWrapped {
+                internalDb.useConnection(readOnly = true) { connection ->
+                    connection.usePrepared(encoder.sql) { stmt -> encoder.encode(stmt, sink, limit) }
+                }
+            } ?: return null
+
+        return EncodedCrudBatch(result.count, result.lastClientId, result.hasMore, onComplete = { writeCheckpoint ->
+            handleWriteCheckpoint(result.lastClientId, writeCheckpoint)
+        })
+    }
+
     override fun getCrudTransactions(): Flow<CrudTransaction> =
         flow {
             waitReady()
@@ -324,6 +355,12 @@ internal class PowerSyncDatabaseImpl(
             }
         }
 
+    override fun rowChanges(tables: Set<String>): Flow<RowChangeset> =
+        flow {
+            waitReady()
+            emitAll(internalDb.rowChanges(tables))
+        }
+
     override fun syncStream(
         name: String,
         parameters: Map<String, JsonParam>?,
@@ -393,6 +430,18 @@ internal class PowerSyncDatabaseImpl(
             emitAll(internalDb.watch(sql, parameters, throttleMs, mapper))
         }
 
+    override fun <RowType : Any> watchDiff(
+        sql: String,
+        parameters: List<Any?>?,
+        keyColumn: String,
+        throttleMs: Long,
+        mapper: (SqlCursor) -> RowType,
+    ): Flow<QueryDiff<RowType>> =
+        flow {
+            waitReady()
+            emitAll(internalDb.watchDiff(sql, parameters, keyColumn, throttleMs, mapper))
+        }
+
     override suspend fun <R> readLock(callback: ThrowableLockCallback<R>): R {
         waitReady()
         return internalDb.readLock(callback)
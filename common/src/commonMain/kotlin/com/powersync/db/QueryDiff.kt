@@ -0,0 +1,67 @@
+package com.powersync.db
+
+import com.powersync.ExperimentalPowerSyncAPI
+
+/**
+ * A result emitted by [com.powersync.PowerSyncDatabase.watchDiff].
+ *
+ * Rows are identified across results by the key column passed to `watchDiff`. Rows whose columns
+ * didn't change are not mapped again, so they're represented by the same instance in [rows] as in
+ * the previous result.
+ */
+@ExperimentalPowerSyncAPI
+public class QueryDiff<out RowType : Any> internal constructor(
+    /**
+     * The complete result of the query.
+     */
+    public val rows: List<RowType>,
+    /**
+     * Changes from the previous result to [rows]. For the first result, all rows are reported as
+     * [RowDiff.Inserted].
+     *
+     * [RowDiff.Removed] changes are reported first. Indices of removed rows and the source of moved
+     * rows refer to the previous result, all other indices refer to [rows].
+     */
+    public val changes: List<RowDiff<RowType>>,
+)
+
+/**
+ * A change to a single row in a [QueryDiff].
+ */
+@ExperimentalPowerSyncAPI
+public sealed class RowDiff<out RowType : Any> {
+    /**
+     * A row with a key that wasn't part of the previous result.
+     */
+    public data class Inserted<out RowType : Any>(
+        public val index: Int,
+        public val row: RowType,
+    ) : RowDiff<RowType>()
+
+    /**
+     * A row that has been removed from the result.
+     */
+    public data class Removed<out RowType : Any>(
+        public val previousIndex: Int,
+        public val row: RowType,
+    ) : RowDiff<RowType>()
+
+    /**
+     * A row that is still part of the result, but at a different position relative to other rows
+     * that haven't moved. This is reported in addition to [Updated] if the row has also changed.
+     */
+    public data class Moved<out RowType : Any>(
+        public val previousIndex: Int,
+        public val index: Int,
+        public val row: RowType,
+    ) : RowDiff<RowType>()
+
+    /**
+     * A row with at least one column that changed since the previous result.
+     */
+    public data class Updated<out RowType : Any>(
+        public val index: Int,
+        public val previous: RowType,
+        public val row: RowType,
+    ) : RowDiff<RowType>()
+}
@@ -0,0 +1,261 @@
+package com.powersync.db
+
+import com.powersync.ExperimentalPowerSyncAPI
+import com.powersync.PowerSyncException
+
+/**
+ * Row-level changes recorded by the SQLite session extension for a single write on the database.
+ *
+ * [bytes] is a changeset in the format described in the
+ * [SQLite session documentation](https://www.sqlite.org/sessionintro.html), so it can be stored or
+ * forwarded as-is. Use [changes] to decode it.
+ *
+ * Tables managed by PowerSync are stored as `ps_data__<name>` (or `ps_data_local__<name>` for
+ * local-only tables) with an `id` primary key at column 0 and a JSON `data` column at column 1.
+ */
+@ExperimentalPowerSyncAPI
+public class RowChangeset(
+    public val bytes: ByteArray,
+) {
+    /**
+     * Decodes all changes in this changeset.
+     */
+    public fun changes(): List<RowChange> =
+        buildList {
+            ChangesetReader(bytes).forEachTable { table ->
+                table.forEachChange { add(it.decode()) }
+            }
+        }
+
+    /**
+     * Returns a changeset only containing changes on tables in [tableNames], or `null` if no such
+     * changes exist.
+     */
+    internal fun filterTables(tableNames: Set<String>): RowChangeset? {
+        var retained: ByteArray? = null
+        var retainedSize = 0
+        var isComplete = true
+
+        ChangesetReader(bytes).forEachTable { table ->
+            table.forEachChange { }
+
+            if (table.name in tableNames) {
+                val length = table.end - table.start
+                val target = retained ?: ByteArray(bytes.size).also { retained = it }
+                bytes.copyInto(target, retainedSize, table.start, table.end)
+                retainedSize += length
+            } else {
+                isComplete = false
+            }
+        }
+
+        return when {
+            isComplete -> this
+            retainedSize == 0 -> null
+            else -> RowChangeset(retained!!.copyOf(retainedSize))
+        }
+    }
+}
+
+/**
+ * A single row changed in a [RowChangeset].
+ */
+@ExperimentalPowerSyncAPI
+public class RowChange internal constructor(
+    /**
+     * The name of the changed SQLite table.
+     */
+    public val table: String,
+    public val operation: Operation,
+    /**
+     * Whether this change was made by a trigger or foreign key action instead of a statement on
+     * the table directly.
+     */
+    public val indirect: Boolean,
+    /**
+     * Values of the primary key columns identifying the changed row.
+     */
+    public val primaryKey: List<Any?>,
+    /**
+     * Values before the change, keyed by column index.
+     *
+     * For deletes, this contains all columns. For updates, this only contains the primary key and
+     * columns that have been changed.
+     */
+    public val oldValues: Map<Int, Any?>,
+    /**
+     * Values after the change, keyed by column index.
+     *
+     * For inserts, this contains all columns. For updates, this only contains changed columns.
+     */
+    public val newValues: Map<Int, Any?>,
+) {
+    public enum class Operation {
+        INSERT,
+        UPDATE,
+        DELETE,
+    }
+
+    override fun toString(): String = "RowChange($operation $table $primaryKey, old: $oldValues, new: $newValues)"
+}
+
+/**
+ * A forward-only reader for the SQLite changeset format.
+ */
+@OptIn(ExperimentalPowerSyncAPI::class)
+private class ChangesetReader(
+    private val bytes: ByteArray,
+) {
+    private var offset = 0
+
+    fun forEachTable(block: (TableSection) -> Unit) {
+        while (offset < bytes.size) {
+            val start = offset
+            val marker = readByte()
+            if (marker != 'T'.code) {
+                throw PowerSyncException("Unexpected changeset table marker $marker at $start", null)
+            }
+
+            val columnCount = readVarint().toInt()
+            val primaryKeyColumns = BooleanArray(columnCount) { readByte() != 0 }
+            val nameEnd = bytes.indexOfNul(offset)
+            val name = bytes.decodeToString(offset, nameEnd)
+            offset = nameEnd + 1
+
+            block(TableSection(name, primaryKeyColumns, start))
+        }
+    }
+
+    inner class TableSection(
+        val name: String,
+        val primaryKeyColumns: BooleanArray,
+        val start: Int,
+    ) {
+        var end: Int = start
+            private set
+
+        fun forEachChange(block: (ChangeRecord) -> Unit) {
+            while (offset < bytes.size && bytes[offset].toInt() != 'T'.code) {
+                val op = readByte()
+                val indirect = readByte() != 0
+                val operation =
+                    when (op) {
+                        SQLITE_INSERT -> RowChange.Operation.INSERT
+                        SQLITE_UPDATE -> RowChange.Operation.UPDATE
+                        SQLITE_DELETE -> RowChange.Operation.DELETE
+                        else -> throw PowerSyncException("Unexpected changeset operation $op", null)
+                    }
+
+                val old = if (operation != RowChange.Operation.INSERT) readRecord() else null
+                val new = if (operation != RowChange.Operation.DELETE) readRecord() else null
+                block(ChangeRecord(this, operation, indirect, old, new))
+            }
+
+            end = offset
+        }
+    }
+
+    inner class ChangeRecord(
+        private val table: TableSection,
+        private val operation: RowChange.Operation,
+        private val indirect: Boolean,
+        private val old: Array<Any?>?,
+        private val new: Array<Any?>?,
+    ) {
+        fun decode(): RowChange {
+            val pkSource = old ?: new!!
+            val primaryKey =
+                table.primaryKeyColumns.indices
+                    .filter { table.primaryKeyColumns[it] }
+                    .map { pkSource[it] }
+
+            return RowChange(
+                table = table.name,
+                operation = operation,
+                indirect = indirect,
+                primaryKey = primaryKey,
+                oldValues = old?.toDefinedMap() ?: emptyMap(),
+                newValues = new?.toDefinedMap() ?: emptyMap(),
+            )
+        }
+
+        private fun Array<Any?>.toDefinedMap(): Map<Int, Any?> =
+            buildMap {
+                this@toDefinedMap.forEachIndexed { index, value ->
+                    if (value !== Undefined) {
+                        put(index, value)
+                    }
+                }
+            }
+    }
+
+    private fun TableSection.readRecord(): Array<Any?> = Array(primaryKeyColumns.size) { readValue() }
+
+    private fun readValue(): Any? =
+        when (val type = readByte()) {
+            0 -> Undefined
+            1 -> readInt64()
+            2 -> Double.fromBits(readInt64())
+            3 -> {
+                val length = readVarint().toInt()
+                bytes.decodeToString(offset, offset + length).also { offset += length }
+            }
+            4 -> {
+                val length = readVarint().toInt()
+                bytes.copyOfRange(offset, offset + length).also { offset += length }
+            }
+            5 -> null
+            else -> throw PowerSyncException("Unexpected changeset value type $type", null)
+        }
+
+    private fun readByte(): Int {
+        if (offset >= bytes.size) {
+            throw PowerSyncException("Unexpected end of changeset", null)
+        }
+
+        return bytes[offset++].toInt() and 0xFF
+    }
+
+    private fun readInt64(): Long {
+        var value = 0L
+        repeat(8) {
+            value = (value shl 8) or readByte().toLong()
+        }
+        return value
+    }
+
+    /**
+     * Reads a SQLite varint: Up to eight bytes with seven bits each and a continuation bit,
+     * followed by a ninth byte contributing all eight bits.
+     */
+    private fun readVarint(): Long {
+        var value = 0L
+        repeat(8) {
+            val byte = readByte()
+            value = (value shl 7) or (byte and 0x7F).toLong()
+            if (byte and 0x80 == 0) {
+                return value
+            }
+        }
+
+        return (value shl 8) or readByte().toLong()
+    }
+
+    private fun ByteArray.indexOfNul(from: Int): Int {
+        for (i in from until size) {
+            if (this[i].toInt() == 0) {
+                return i
+            }
+        }
+
+        throw PowerSyncException("Unterminated table name in changeset", null)
+    }
+
+    private object Undefined
+
+    private companion object {
+        const val SQLITE_DELETE = 9
+        const val SQLITE_INSERT = 18
+        const val SQLITE_UPDATE = 23
+    }
+}
@@ -57,27 +57,32 @@ internal class StatementBasedCursor(
     override val columnCount: Int
         get() = stmt.getColumnCount()
 
-    override val columnNames: Map<String, Int> by lazy {
-        buildMap {
-            stmt.getColumnNames().forEachIndexed { index, key ->
-                val finalKey =
-                    if (containsKey(key)) {
-                        var index = 1
-                        val basicKey = "$key&JOIN"
-                        var finalKey = basicKey + index
-                        while (containsKey(finalKey)) {
-                            finalKey = basicKey + ++index
-                        }
-                        finalKey
-                    } else {
-                        key
+    override val columnNames: Map<String, Int> by lazy { columnIndices(stmt.getColumnNames()) }
+}
+
+/**
+ * Resolves column names to their index, renaming duplicate columns (e.g. from joins) so that they
+ * stay accessible by name.
+ */
+internal fun columnIndices(names: List<String>): Map<String, Int> =
+    buildMap {
+        names.forEachIndexed { index, key ->
+            val finalKey =
+                if (containsKey(key)) {
+                    var index = 1
+                    val basicKey = "$key&JOIN"
+                    var finalKey = basicKey + index
+                    while (containsKey(finalKey)) {
+                        finalKey = basicKey + ++index
                     }
+                    finalKey
+                } else {
+                    key
+                }
 
-                put(finalKey, index)
-            }
+            put(finalKey, index)
         }
     }
-}
 
 private inline fun <T> SqlCursor.getColumnValueOptional(
     name: String,
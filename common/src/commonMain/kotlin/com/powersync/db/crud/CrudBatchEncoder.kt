@@ -0,0 +1,86 @@
+package com.powersync.db.crud
+
+import androidx.sqlite.SQLiteStatement
+import com.powersync.ExperimentalPowerSyncAPI
+import com.powersync.utils.JsonUtil
+import kotlinx.io.Sink
+
+/**
+ * Writes entries of the `ps_crud` table to a [Sink] without parsing them.
+ *
+ * The `data` column already contains the JSON representation of each entry, so it's copied to the
+ * sink as-is (as UTF-8 bytes read from SQLite). When [fields] are given, SQLite removes all other
+ * top-level keys from entries before they're read.
+ */
+@OptIn(ExperimentalPowerSyncAPI::class)
+internal class CrudBatchEncoder(
+    private val encoding: CrudEncoding,
+    private val fields: Set<String>?,
+) {
+    val sql: String =
+        if (fields == null) {
+            "SELECT id, data FROM ps_crud ORDER BY id ASC LIMIT ?"
+        } else {
+            """
+            SELECT id, (
+              SELECT json_group_object(key, value) FROM json_each(ps_crud.data)
+                WHERE key IN (SELECT value FROM json_each(?))
+            ) FROM ps_crud ORDER BY id ASC LIMIT ?
+            """.trimIndent()
+        }
+
+    /**
+     * Binds parameters for [sql] and writes at most [limit] entries to the [sink].
+     *
+     * Nothing is written if there are no entries. The sink is not flushed.
+     */
+    fun encode(
+        stmt: SQLiteStatement,
+        sink: Sink,
+        limit: Int,
+    ): Result? {
+        var index = 1
+        if (fields != null) {
+            stmt.bindText(index++, JsonUtil.json.encodeToString(fields.toList()))
+        }
+        // Query one more entry to determine whether there are more entries.
+        stmt.bindLong(index, limit.toLong() + 1)
+
+        var count = 0
+        var lastClientId = 0
+        while (count < limit && stmt.step()) {
+            if (count == 0) {
+                if (encoding == CrudEncoding.JSON_ARRAY) sink.writeByte(ARRAY_START)
+            } else if (encoding == CrudEncoding.JSON_ARRAY) {
+                sink.writeByte(SEPARATOR)
+            }
+
+            lastClientId = stmt.getLong(0).toInt()
+            // Reading text as a blob gives us the UTF-8 bytes without decoding them.
+            sink.write(stmt.getBlob(1))
+            if (encoding == CrudEncoding.NDJSON) sink.writeByte(NEWLINE)
+            count++
+        }
+
+        if (count == 0) {
+            return null
+        }
+
+        val hasMore = stmt.step()
+        if (encoding == CrudEncoding.JSON_ARRAY) sink.writeByte(ARRAY_END)
+        return Result(count, lastClientId, hasMore)
+    }
+
+    class Result(
+        val count: Int,
+        val lastClientId: Int,
+        val hasMore: Boolean,
+    )
+
+    private companion object {
+        const val ARRAY_START: Byte = 0x5B // [
+        const val ARRAY_END: Byte = 0x5D // ]
+        const val SEPARATOR: Byte = 0x2C // ,
+        const val NEWLINE: Byte = 0x0A
+    }
+}
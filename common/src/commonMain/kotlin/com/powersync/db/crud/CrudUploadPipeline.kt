@@ -0,0 +1,89 @@
+package com.powersync.db.crud
+
+import com.powersync.ExperimentalPowerSyncAPI
+import com.powersync.PowerSyncDatabase
+import com.powersync.PowerSyncException
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.Deferred
+import kotlinx.coroutines.async
+import kotlinx.coroutines.flow.buffer
+import kotlinx.coroutines.supervisorScope
+import kotlinx.coroutines.sync.Semaphore
+
+/**
+ * Uploads all pending transactions with [upload], reading transactions ahead of time and
+ * optionally running multiple uploads concurrently.
+ *
+ * This is meant to be called from [com.powersync.connectors.PowerSyncBackendConnector.uploadData]
+ * when there is a large backlog of local changes. While a transaction is being uploaded, up to
+ * [prefetch] following transactions are already read from the database, so that uploads don't
+ * have to wait for the next database query. With [maxConcurrentUploads] greater than one,
+ * multiple transactions are uploaded at the same time. Since they can reach the backend out of
+ * order, this should only be enabled if the backend can apply transactions independently.
+ *
+ * [upload] returns an optional write checkpoint. Transactions are [completed][CrudTransaction.complete]
+ * in order: once an upload finishes, it is acknowledged together with all following transactions
+ * that have already been uploaded. If an upload fails, uploads still in flight are cancelled and
+ * the error is rethrown. Transactions uploaded before the failing one stay completed, while the
+ * failed transaction and all transactions after it stay in the upload queue to be retried later
+ * (which may upload some of them again).
+ */
+@ExperimentalPowerSyncAPI
+@Throws(PowerSyncException::class, CancellationException::class)
+public suspend fun PowerSyncDatabase.uploadCrudTransactions(
+    prefetch: Int = 4,
+    maxConcurrentUploads: Int = 1,
+    upload: suspend (CrudTransaction) -> String?,
+) {
+    require(prefetch >= 0) { "prefetch must not be negative" }
+    require(maxConcurrentUploads >= 1) { "maxConcurrentUploads must be at least 1" }
+
+    supervisorScope {
+        val permits = Semaphore(maxConcurrentUploads)
+        val inFlight = ArrayDeque<InFlightUpload>()
+
+        // Completes the longest run of finished uploads at the start of the queue. With
+        // waitForAll, waits for all uploads to finish.
+        suspend fun acknowledge(waitForAll: Boolean) {
+            var acknowledged: InFlightUpload? = null
+            var checkpoint: String? = null
+            try {
+                while (inFlight.isNotEmpty()) {
+                    val next = inFlight.first()
+                    if (!waitForAll && !next.result.isCompleted) break
+
+                    checkpoint = next.result.await()
+                    acknowledged = inFlight.removeFirst()
+                }
+            } finally {
+                acknowledged?.transaction?.complete(checkpoint)
+            }
+        }
+
+        try {
+            getCrudTransactions().buffer(prefetch).collect { transaction ->
+                permits.acquire()
+                val result =
+                    async {
+                        try {
+                            upload(transaction)
+                        } finally {
+                            permits.release()
+                        }
+                    }
+
+                inFlight.addLast(InFlightUpload(transaction, result))
+                acknowledge(waitForAll = false)
+            }
+
+            acknowledge(waitForAll = true)
+        } finally {
+            inFlight.forEach { it.result.cancel() }
+        }
+    }
+}
+
+private class InFlightUpload(
+    val transaction: CrudTransaction,
+    val result: Deferred<String?>,
+)
@@ -0,0 +1,52 @@
+package com.powersync.db.crud
+
+import com.powersync.ExperimentalPowerSyncAPI
+
+/**
+ * Formats in which [com.powersync.PowerSyncDatabase.writeCrudBatch] can write entries.
+ *
+ * Each entry is the JSON object recorded for the change, with the `op`, `type`, `id` and (where
+ * applicable) `data`, `old` and `metadata` keys also exposed by [CrudEntry].
+ */
+@ExperimentalPowerSyncAPI
+public enum class CrudEncoding {
+    /**
+     * Writes entries as a single JSON array.
+     */
+    JSON_ARRAY,
+
+    /**
+     * Writes each entry as a JSON object followed by a newline.
+     */
+    NDJSON,
+}
+
+/**
+ * Describes a batch of client-side changes written by
+ * [com.powersync.PowerSyncDatabase.writeCrudBatch].
+ */
+@ExperimentalPowerSyncAPI
+public class EncodedCrudBatch internal constructor(
+    /**
+     * The amount of entries written.
+     */
+    public val size: Int,
+    /**
+     * The client id of the last entry written, see [CrudEntry.clientId].
+     */
+    public val lastClientId: Int,
+    /**
+     * true if there are more changes in the local queue.
+     */
+    public val hasMore: Boolean,
+    private val onComplete: suspend (writeCheckpoint: String?) -> Unit,
+) {
+    /**
+     * Call to remove the changes from the local queue, once successfully uploaded.
+     *
+     * [writeCheckpoint] is optional.
+     */
+    public suspend fun complete(writeCheckpoint: String? = null) {
+        onComplete(writeCheckpoint)
+    }
+}
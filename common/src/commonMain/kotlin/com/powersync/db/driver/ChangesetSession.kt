@@ -0,0 +1,31 @@
+package com.powersync.db.driver
+
+import androidx.sqlite.SQLiteConnection
+import com.powersync.ExperimentalPowerSyncAPI
+
+/**
+ * A [SQLiteConnection] that can record row-level changes with the SQLite session extension.
+ *
+ * Connections opened by the PowerSync SDK on Kotlin/Native platforms and connections opened by the
+ * encryption-enabled JNI driver implement this interface. When the write connection of a pool
+ * implements it, [com.powersync.PowerSyncDatabase.rowChanges] is available.
+ */
+@ExperimentalPowerSyncAPI
+public interface SessionRecordingConnection : SQLiteConnection {
+    /**
+     * Starts recording changes to all tables in the `main` schema of this connection.
+     */
+    public fun openChangesetSession(): ChangesetSession
+}
+
+/**
+ * An active `sqlite3_session` attached to all tables of a connection.
+ */
+@ExperimentalPowerSyncAPI
+public interface ChangesetSession : AutoCloseable {
+    /**
+     * Returns all changes recorded since this session was opened in the changeset format, or
+     * `null` if no changes have been recorded.
+     */
+    public fun changeset(): ByteArray?
+}
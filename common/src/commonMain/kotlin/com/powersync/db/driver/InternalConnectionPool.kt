@@ -4,6 +4,7 @@ import androidx.sqlite.SQLiteConnection
 import androidx.sqlite.execSQL
 import com.powersync.ExperimentalPowerSyncAPI
 import com.powersync.PersistentConnectionFactory
+import com.powersync.db.RowChangeset
 import com.powersync.utils.JsonUtil
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
@@ -22,9 +23,15 @@ internal class InternalConnectionPool(
     private val dbFilename: String,
     private val dbDirectory: String?,
     private val writeLockMutex: Mutex,
-) : SQLiteConnectionPool {
+    readPoolOptions: ReadPoolOptions = ReadPoolOptions(),
+) : SQLiteConnectionPool,
+    RowChangeSource,
+    SchemaAwarePool {
     private val writeConnection = newConnection(false)
-    private val readPool = ReadPool({ newConnection(true) }, scope = scope)
+    private val writeStatements = StatementCache()
+    private val readPool = ReadPool({ newConnection(true) }, readPoolOptions, scope)
+    private val rowChangeRecorder =
+        (writeConnection as? SessionRecordingConnection)?.let(::RowChangeRecorder)
 
     // MutableSharedFlow to emit batched table updates
     private val tableUpdatesFlow = MutableSharedFlow<Set<String>>(replay = 0)
@@ -56,8 +63,9 @@ internal class InternalConnectionPool(
     override suspend fun <T> write(callback: suspend (SQLiteConnectionLease) -> T): T =
         writeLockMutex.withLock {
             withContext(dispatcher) {
+                rowChangeRecorder?.beforeWrite()
                 try {
-                    callback(RawConnectionLease(writeConnection))
+                    callback(RawConnectionLease(writeConnection, writeStatements))
                 } finally {
                     // When we've leased a write connection, we may have to update table update flows
                     // after users ran their custom statements.
@@ -67,6 +75,8 @@ internal class InternalConnectionPool(
                             tableUpdatesFlow.emit(updatedTables)
                         }
                     }
+
+                    rowChangeRecorder?.afterWrite()
                 }
             }
         }
@@ -83,10 +93,19 @@ internal class InternalConnectionPool(
         }
     }
 
+    override fun onSchemaChanged() {
+        readPool.invalidateSchema()
+    }
+
     override val updates: SharedFlow<Set<String>>
         get() = tableUpdatesFlow
 
+    override val rowChanges: SharedFlow<RowChangeset>?
+        get() = rowChangeRecorder?.rowChanges
+
     override suspend fun close() {
+        rowChangeRecorder?.close()
+        writeStatements.clear()
         writeConnection.close()
         readPool.close()
     }
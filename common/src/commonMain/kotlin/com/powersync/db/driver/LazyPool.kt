@@ -1,6 +1,7 @@
 package com.powersync.db.driver
 
 import com.powersync.ExperimentalPowerSyncAPI
+import com.powersync.db.RowChangeset
 import kotlinx.coroutines.flow.SharedFlow
 
 /**
@@ -13,7 +14,9 @@ import kotlinx.coroutines.flow.SharedFlow
 @OptIn(ExperimentalPowerSyncAPI::class)
 internal class LazyPool(
     openInner: () -> SQLiteConnectionPool,
-) : SQLiteConnectionPool {
+) : SQLiteConnectionPool,
+    RowChangeSource,
+    SchemaAwarePool {
     private val lazyPool = lazy(openInner)
     private val pool by lazyPool
 
@@ -27,6 +30,13 @@ internal class LazyPool(
     override val updates: SharedFlow<Set<String>>
         get() = pool.updates
 
+    override fun onSchemaChanged() {
+        pool.notifySchemaChanged()
+    }
+
+    override val rowChanges: SharedFlow<RowChangeset>?
+        get() = pool.recordedRowChanges()
+
     override suspend fun close() {
         if (lazyPool.isInitialized()) {
             pool.close()
@@ -7,10 +7,13 @@ import com.powersync.ExperimentalPowerSyncAPI
 /**
  * A temporary view / lease of an inner [androidx.sqlite.SQLiteConnection] managed by the PowerSync
  * SDK.
+ *
+ * When [statements] is set, it's used for [usePreparedCached]. It must belong to [connection].
  */
 @OptIn(ExperimentalPowerSyncAPI::class)
 internal class RawConnectionLease(
     private val connection: SQLiteConnection,
+    private val statements: StatementCache? = null,
 ) : SQLiteConnectionLease {
     private var isCompleted = false
 
@@ -37,4 +40,29 @@ internal class RawConnectionLease(
         checkNotCompleted()
         return connection.prepare(sql).use(block)
     }
+
+    override suspend fun <R> usePreparedCached(
+        key: Any,
+        sql: String,
+        block: (SQLiteStatement) -> R,
+    ): R {
+        checkNotCompleted()
+        return if (statements != null) {
+            statements.use(connection, key, sql, block)
+        } else {
+            connection.prepare(sql).use(block)
+        }
+    }
+
+    fun clearCachedStatements() {
+        statements?.clear()
+    }
+}
+
+/**
+ * Closes statements cached for the connection of this lease, which is necessary after changing the
+ * schema.
+ */
+internal fun SQLiteConnectionLease.clearCachedStatements() {
+    (this as? RawConnectionLease)?.clearCachedStatements()
 }
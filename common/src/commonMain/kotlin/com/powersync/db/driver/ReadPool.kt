@@ -1,106 +1,471 @@
 package com.powersync.db.driver
 
 import androidx.sqlite.SQLiteConnection
+import androidx.sqlite.execSQL
 import com.powersync.ExperimentalPowerSyncAPI
 import com.powersync.PowerSyncException
+import io.ktor.utils.io.InternalAPI
+import io.ktor.utils.io.locks.SynchronizedObject
+import io.ktor.utils.io.locks.synchronized
 import kotlinx.coroutines.CancellationException
 import kotlinx.coroutines.CompletableDeferred
 import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.IO
 import kotlinx.coroutines.Job
-import kotlinx.coroutines.channels.Channel
-import kotlinx.coroutines.channels.ClosedSendChannelException
-import kotlinx.coroutines.joinAll
+import kotlinx.coroutines.NonCancellable
+import kotlinx.coroutines.currentCoroutineContext
+import kotlinx.coroutines.delay
 import kotlinx.coroutines.launch
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlinx.coroutines.withContext
+import kotlin.coroutines.CoroutineContext
+import kotlin.time.Duration
+import kotlin.time.TimeMark
+import kotlin.time.TimeSource
+
+/**
+ * The priority with which a read is scheduled in a [ReadPool], taken from the coroutine context of
+ * the reader.
+ */
+internal enum class ReadPriority : CoroutineContext.Element {
+    /**
+     * Reads issued by users directly. This is the default for reads without a priority.
+     */
+    INTERACTIVE,
+
+    /**
+     * Reads that aren't awaited by users directly, like re-running watched queries.
+     */
+    BACKGROUND,
+    ;
+
+    override val key: CoroutineContext.Key<*>
+        get() = Key
+
+    companion object Key : CoroutineContext.Key<ReadPriority>
+}
 
 /**
  * The read-part of a [SQLiteConnectionPool] backed by connections owned by the PowerSync SDK.
+ *
+ * The pool keeps between [ReadPoolOptions.minSize] and [ReadPoolOptions.maxSize] connections open.
+ * Connections are opened when all existing connections are in use, and closed again after being
+ * idle for [ReadPoolOptions.idleTimeout]. When no connection can be opened, readers wait in a queue
+ * for their [ReadPriority], where interactive reads are served first. Background reads that have
+ * been waiting for longer than [ReadPoolOptions.backgroundAgingThreshold] are served before
+ * interactive reads to avoid starving them.
+ *
+ * After the schema has been changed on the write connection, [invalidateSchema] marks all
+ * connections as outdated. Instead of waiting for all readers, each connection reloads the schema
+ * the next time it's leased.
  */
-@OptIn(ExperimentalPowerSyncAPI::class)
+@OptIn(ExperimentalPowerSyncAPI::class, InternalAPI::class)
 internal class ReadPool(
-    factory: () -> SQLiteConnection,
-    size: Int = 5,
+    private val factory: () -> SQLiteConnection,
+    private val options: ReadPoolOptions = ReadPoolOptions(),
     private val scope: CoroutineScope,
-) {
-    private val available =
-        Channel<Pair<SQLiteConnection, CompletableDeferred<Unit>>>(
-            // If an element is sent but not delivered - e.g. the receiving read()/withAllConnections
-            // coroutine was cancelled during the channel rendezvous, or the channel is closed with an
-            // element in flight - complete its `done` so the owning worker returns the connection to
-            // the pool instead of parking in done.await() forever. Without this, a single read
-            // cancelled at the wrong moment permanently shrinks the pool and deadlocks any later
-            // withAllConnections()/updateSchema().
-            onUndeliveredElement = { (_, done) -> done.complete(Unit) },
-        )
-    private val connections: List<Job> =
-        List(size) {
-            val driver = factory()
+) : SynchronizedObject() {
+    // All fields below are guarded by synchronizing on this pool.
 
-            scope.launch {
-                try {
-                    while (true) {
-                        val done = CompletableDeferred<Unit>()
-                        try {
-                            available.send(driver to done)
-                        } catch (_: ClosedSendChannelException) {
-                            break // Pool closed
-                        }
+    // Connections not currently in use, the most recently used connection is last.
+    private val idle = ArrayDeque<IdleConnection>()
+    private val interactiveWaiters = ArrayDeque<Waiter>()
+    private val backgroundWaiters = ArrayDeque<Waiter>()
+
+    // The amount of open connections, including connections in use and connections being opened.
+    private var openConnections = 0
+    private var exclusive: ExclusiveRequest? = null
+    private var closed: CompletableDeferred<Unit>? = null
+
+    private var reaper: Job? = null
+    private var reapEpoch = 0L
+
+    // Incremented by invalidateSchema, and the value each open connection has last seen.
+    private var schemaGeneration = 0L
+    private val connectionSchemas = HashMap<SQLiteConnection, Long>()
+
+    private var totalLeases = 0L
+    private var totalWaitTime = Duration.ZERO
+    private var maxWaitTime = Duration.ZERO
+
+    // Ensures requests for all connections are processed one after the other.
+    private val exclusiveMutex = Mutex()
+
+    init {
+        repeat(options.minSize) {
+            val connection = factory()
+            connectionSchemas[connection] = schemaGeneration
+            idle.addLast(IdleConnection(connection, reapEpoch))
+            openConnections++
+        }
+        publishState()
+    }
+
+    suspend fun <T> read(block: suspend (SQLiteConnectionLease) -> T): T {
+        val connection = acquire()
+
+        try {
+            refreshSchemaIfOutdated(connection)
+            return block(RawConnectionLease(connection))
+        } finally {
+            release(connection)
+        }
+    }
+
+    /**
+     * Makes connections reload the schema before they're leased again, because it has been
+     * changed on another connection.
+     */
+    fun invalidateSchema() {
+        synchronized(this) {
+            schemaGeneration++
+        }
+    }
+
+    private suspend fun refreshSchemaIfOutdated(connection: SQLiteConnection) {
+        val generation =
+            synchronized(this) {
+                schemaGeneration.takeIf { connectionSchemas[connection] != it }
+            } ?: return
 
-                        done.await()
+        // SQLite checks the schema when preparing statements, but views referencing tables that
+        // don't exist in the cached schema can fail to prepare. Reading the schema reloads it.
+        withContext(Dispatchers.IO) {
+            connection.execSQL("pragma table_info('sqlite_master')")
+        }
+        synchronized(this) {
+            connectionSchemas[connection] = generation
+        }
+    }
+
+    suspend fun <R> withAllConnections(action: suspend (connections: List<SQLiteConnection>) -> R): R =
+        exclusiveMutex.withLock {
+            val request = ExclusiveRequest()
+            synchronized(this) {
+                if (closed != null) {
+                    throw poolClosed()
+                }
+
+                // From now on, connections that are returned are collected by this request instead
+                // of being handed to other readers, and no new connections are opened.
+                exclusive = request
+                while (idle.isNotEmpty()) {
+                    request.collected.add(idle.removeFirst().connection)
+                }
+                request.completeIfAllCollected()
+                publishState()
+            }
+
+            val toClose = mutableListOf<SQLiteConnection>()
+            try {
+                request.granted.await()
+                action(request.collected.toList())
+            } finally {
+                synchronized(this) {
+                    exclusive = null
+                    request.collected.forEach { connection ->
+                        returnConnection(connection)?.let(toClose::add)
                     }
-                } finally {
-                    driver.close()
+
+                    // Readers that queued up while we held all connections may be able to open
+                    // new ones.
+                    if (closed == null) {
+                        while (openConnections < options.maxSize) {
+                            val waiter = nextWaiter() ?: break
+                            openConnections++
+                            recordLease(waiter.enqueuedAt.elapsedNow())
+                            waiter.deferred.complete(null)
+                        }
+                    }
+                    publishState()
                 }
+
+                toClose.forEach { it.close() }
             }
         }
 
-    suspend fun <T> read(block: suspend (SQLiteConnectionLease) -> T): T {
-        val (connection, done) =
+    suspend fun close() {
+        val toClose = mutableListOf<SQLiteConnection>()
+        val done =
+            synchronized(this) {
+                closed?.let { return@synchronized it }
+
+                val done = CompletableDeferred<Unit>()
+                closed = done
+                reaper?.cancel()
+                reaper = null
+
+                for (waiter in interactiveWaiters + backgroundWaiters) {
+                    waiter.deferred.completeExceptionally(poolClosed())
+                }
+                interactiveWaiters.clear()
+                backgroundWaiters.clear()
+                exclusive?.granted?.completeExceptionally(poolClosed())
+
+                idle.forEach {
+                    toClose.add(it.connection)
+                    connectionSchemas.remove(it.connection)
+                }
+                openConnections -= idle.size
+                idle.clear()
+
+                // Connections currently in use are closed when they're returned.
+                if (openConnections == 0) {
+                    done.complete(Unit)
+                }
+                publishState()
+                done
+            }
+
+        toClose.forEach { it.close() }
+        done.await()
+    }
+
+    private suspend fun acquire(): SQLiteConnection {
+        val priority = currentCoroutineContext()[ReadPriority] ?: ReadPriority.INTERACTIVE
+
+        val waiter =
+            synchronized(this) {
+                if (closed != null) {
+                    throw poolClosed()
+                }
+
+                if (exclusive == null) {
+                    idle.removeLastOrNull()?.let {
+                        recordLease(Duration.ZERO)
+                        return it.connection
+                    }
+
+                    if (openConnections < options.maxSize) {
+                        openConnections++
+                        recordLease(Duration.ZERO)
+                        null
+                    } else {
+                        enqueue(priority)
+                    }
+                } else {
+                    enqueue(priority)
+                }
+            }
+
+        return if (waiter == null) openConnection() else waiter.await()
+    }
+
+    private fun enqueue(priority: ReadPriority): Waiter {
+        val waiter = Waiter(priority, TimeSource.Monotonic.markNow())
+        waitersFor(priority).addLast(waiter)
+        publishState()
+        return waiter
+    }
+
+    private suspend fun Waiter.await(): SQLiteConnection {
+        val granted =
             try {
-                available.receive()
-            } catch (e: PoolClosedException) {
-                throw PowerSyncException(
-                    message = "Cannot process connection pool request",
-                    cause = e,
-                )
+                deferred.await()
+            } catch (e: CancellationException) {
+                val handedOver = synchronized(this@ReadPool) { !waitersFor(priority).remove(this) }
+                // If this waiter has been removed from the queue before being cancelled, it has
+                // been granted a connection (or the permission to open one) that we need to return.
+                if (handedOver && deferred.isCompleted && deferred.getCompletionExceptionOrNull() == null) {
+                    deferred.getCompleted()?.let(::release) ?: releaseSlot()
+                }
+                throw e
             }
 
+        // A null value means that we may open a new connection.
+        return granted ?: openConnection()
+    }
+
+    /**
+     * Opens a connection after having reserved a slot for it in [openConnections].
+     */
+    private suspend fun openConnection(): SQLiteConnection {
+        // New connections load the current schema when opened.
+        val generation = synchronized(this) { schemaGeneration }
+        var opened: SQLiteConnection? = null
         try {
-            return block(RawConnectionLease(connection))
-        } finally {
-            done.complete(Unit)
+            // Opening connections is blocking, and must not be interrupted to ensure we don't lose
+            // track of connections.
+            withContext(Dispatchers.IO + NonCancellable) {
+                opened = factory()
+            }
+        } catch (e: Throwable) {
+            opened?.let(::release) ?: releaseSlot()
+            throw e
+        }
+
+        val connection = opened!!
+        synchronized(this) {
+            connectionSchemas[connection] = generation
         }
+        return connection
     }
 
-    suspend fun <R> withAllConnections(action: suspend (connections: List<SQLiteConnection>) -> R): R {
-        val obtainedConnections = mutableListOf<Pair<SQLiteConnection, CompletableDeferred<Unit>>>()
+    private fun release(connection: SQLiteConnection) {
+        val toClose =
+            synchronized(this) {
+                returnConnection(connection).also { publishState() }
+            }
+
+        toClose?.close()
+    }
 
-        try {
-            /*
-             * This attempts to receive (all) the number of available connections.
-             * This creates a hold for each connection received. This means that subsequent
-             * receive operations must return unique connections until all the available connections
-             * have a hold.
-             */
-            repeat(connections.size) {
-                try {
-                    obtainedConnections.add(available.receive())
-                } catch (e: PoolClosedException) {
-                    throw PowerSyncException(
-                        message = "Cannot process connection pool request",
-                        cause = e,
-                    )
+    /**
+     * Makes a connection that is no longer used available again.
+     *
+     * Returns the connection if it must be closed by the caller (outside of the lock).
+     */
+    private fun returnConnection(connection: SQLiteConnection): SQLiteConnection? {
+        closed?.let { done ->
+            openConnections--
+            connectionSchemas.remove(connection)
+            if (openConnections == 0) {
+                done.complete(Unit)
+            }
+            return connection
+        }
+
+        exclusive?.let { request ->
+            request.collected.add(connection)
+            request.completeIfAllCollected()
+            return null
+        }
+
+        val waiter = nextWaiter()
+        if (waiter != null) {
+            recordLease(waiter.enqueuedAt.elapsedNow())
+            waiter.deferred.complete(connection)
+        } else {
+            idle.addLast(IdleConnection(connection, reapEpoch))
+            scheduleReaper()
+        }
+        return null
+    }
+
+    /**
+     * Gives up a slot reserved in [openConnections] without a connection having been opened for
+     * it.
+     */
+    private fun releaseSlot() {
+        synchronized(this) {
+            val waiter = if (closed == null && exclusive == null) nextWaiter() else null
+            if (waiter != null) {
+                // Pass the slot on to the next waiter, which will open a connection for it.
+                recordLease(waiter.enqueuedAt.elapsedNow())
+                waiter.deferred.complete(null)
+            } else {
+                openConnections--
+                closed?.let { if (openConnections == 0) it.complete(Unit) }
+                exclusive?.completeIfAllCollected()
+            }
+            publishState()
+        }
+    }
+
+    private fun nextWaiter(): Waiter? {
+        val background = backgroundWaiters.firstOrNull()
+        if (background != null &&
+            (interactiveWaiters.isEmpty() || background.enqueuedAt.elapsedNow() >= options.backgroundAgingThreshold)
+        ) {
+            return backgroundWaiters.removeFirst()
+        }
+
+        return interactiveWaiters.removeFirstOrNull()
+    }
+
+    private fun waitersFor(priority: ReadPriority): ArrayDeque<Waiter> =
+        when (priority) {
+            ReadPriority.INTERACTIVE -> interactiveWaiters
+            ReadPriority.BACKGROUND -> backgroundWaiters
+        }
+
+    private fun scheduleReaper() {
+        if (reaper != null || openConnections <= options.minSize) {
+            return
+        }
+
+        reaper =
+            scope.launch {
+                while (true) {
+                    // Connections that are idle now and still idle after the delay have been idle
+                    // for at least idleTimeout.
+                    val epoch = synchronized(this@ReadPool) { ++reapEpoch }
+                    delay(options.idleTimeout)
+
+                    val expired = mutableListOf<SQLiteConnection>()
+                    val keepRunning =
+                        synchronized(this@ReadPool) {
+                            while (openConnections > options.minSize && idle.firstOrNull()?.let { it.idleSince < epoch } == true) {
+                                val connection = idle.removeFirst().connection
+                                expired.add(connection)
+                                connectionSchemas.remove(connection)
+                                openConnections--
+                            }
+                            publishState()
+
+                            (openConnections > options.minSize && idle.isNotEmpty()).also {
+                                if (!it) reaper = null
+                            }
+                        }
+
+                    expired.forEach { it.close() }
+                    if (!keepRunning) break
                 }
             }
+    }
 
-            return action(obtainedConnections.map { it.first })
-        } finally {
-            obtainedConnections.forEach { it.second.complete(Unit) }
+    private fun recordLease(waitTime: Duration) {
+        totalLeases++
+        totalWaitTime += waitTime
+        if (waitTime > maxWaitTime) {
+            maxWaitTime = waitTime
         }
     }
 
-    suspend fun close() {
-        available.cancel(PoolClosedException)
-        connections.joinAll()
+    private fun publishState() {
+        val metrics = options.metrics ?: return
+        metrics.mutableState.value =
+            ReadPoolState(
+                openConnections = openConnections,
+                idleConnections = idle.size,
+                queuedInteractiveReads = interactiveWaiters.size,
+                queuedBackgroundReads = backgroundWaiters.size,
+                totalLeases = totalLeases,
+                totalWaitTime = totalWaitTime,
+                maxWaitTime = maxWaitTime,
+            )
+    }
+
+    private fun poolClosed(): PowerSyncException =
+        PowerSyncException(
+            message = "Cannot process connection pool request",
+            cause = PoolClosedException,
+        )
+
+    private class IdleConnection(
+        val connection: SQLiteConnection,
+        val idleSince: Long,
+    )
+
+    private class Waiter(
+        val priority: ReadPriority,
+        val enqueuedAt: TimeMark,
+    ) {
+        // Completed with a connection, or with null to grant permission to open a new connection.
+        val deferred = CompletableDeferred<SQLiteConnection?>()
+    }
+
+    private inner class ExclusiveRequest {
+        val collected = mutableListOf<SQLiteConnection>()
+        val granted = CompletableDeferred<Unit>()
+
+        fun completeIfAllCollected() {
+            if (collected.size == openConnections) {
+                granted.complete(Unit)
+            }
+        }
     }
 }
 
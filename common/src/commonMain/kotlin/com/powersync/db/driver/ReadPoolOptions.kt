@@ -0,0 +1,96 @@
+package com.powersync.db.driver
+
+import com.powersync.ExperimentalPowerSyncAPI
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.asStateFlow
+import kotlin.time.Duration
+import kotlin.time.Duration.Companion.milliseconds
+import kotlin.time.Duration.Companion.seconds
+
+/**
+ * Options for the pool of read connections opened by the PowerSync SDK.
+ */
+@OptIn(ExperimentalPowerSyncAPI::class)
+public class ReadPoolOptions(
+    /**
+     * The amount of read connections to keep open even when they're idle.
+     */
+    public val minSize: Int = 1,
+    /**
+     * The maximum amount of read connections to open concurrently. Reads issued while all
+     * connections are in use wait for one to become available.
+     */
+    public val maxSize: Int = 5,
+    /**
+     * How long a connection may stay idle before it's closed, as long as more than [minSize]
+     * connections are open.
+     */
+    public val idleTimeout: Duration = 30.seconds,
+    /**
+     * How long a background read (like the query of a `watch()` flow) may wait before it's
+     * treated like an interactive read.
+     *
+     * Interactive reads are served before background reads, this ensures background reads can't be
+     * starved by them.
+     */
+    public val backgroundAgingThreshold: Duration = 100.milliseconds,
+    /**
+     * An optional [ReadPoolMetrics] instance to update with the state of the pool.
+     */
+    @ExperimentalPowerSyncAPI
+    public val metrics: ReadPoolMetrics? = null,
+) {
+    init {
+        require(minSize >= 0) { "minSize must not be negative" }
+        require(maxSize >= 1) { "maxSize must be at least 1" }
+        require(minSize <= maxSize) { "minSize must not exceed maxSize" }
+    }
+}
+
+/**
+ * Metrics describing the pool of read connections.
+ *
+ * Pass an instance to [ReadPoolOptions.metrics] and collect [state] to observe it.
+ */
+@ExperimentalPowerSyncAPI
+public class ReadPoolMetrics {
+    internal val mutableState = MutableStateFlow(ReadPoolState())
+
+    public val state: StateFlow<ReadPoolState> = mutableState.asStateFlow()
+}
+
+/**
+ * A snapshot of the state of a read pool.
+ */
+@ExperimentalPowerSyncAPI
+public data class ReadPoolState(
+    /**
+     * The amount of open connections, including those currently in use.
+     */
+    val openConnections: Int = 0,
+    /**
+     * The amount of open connections not currently in use.
+     */
+    val idleConnections: Int = 0,
+    /**
+     * The amount of interactive reads waiting for a connection.
+     */
+    val queuedInteractiveReads: Int = 0,
+    /**
+     * The amount of background reads waiting for a connection.
+     */
+    val queuedBackgroundReads: Int = 0,
+    /**
+     * The total amount of connections handed out by the pool.
+     */
+    val totalLeases: Long = 0,
+    /**
+     * The total time reads have spent waiting for a connection.
+     */
+    val totalWaitTime: Duration = Duration.ZERO,
+    /**
+     * The longest time a read has spent waiting for a connection.
+     */
+    val maxWaitTime: Duration = Duration.ZERO,
+)
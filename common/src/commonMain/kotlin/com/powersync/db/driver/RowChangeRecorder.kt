@@ -0,0 +1,83 @@
+package com.powersync.db.driver
+
+import com.powersync.ExperimentalPowerSyncAPI
+import com.powersync.db.RowChangeset
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.flow.MutableSharedFlow
+import kotlinx.coroutines.flow.SharedFlow
+
+/**
+ * Implemented by connection pools that can report row-level changes made on their write connection,
+ * which are exposed through [com.powersync.PowerSyncDatabase.rowChanges].
+ */
+@ExperimentalPowerSyncAPI
+public interface RowChangeSource {
+    /**
+     * A flow of changesets recorded for each write lease, or `null` if the write connection doesn't
+     * implement [SessionRecordingConnection].
+     */
+    public val rowChanges: SharedFlow<RowChangeset>?
+}
+
+/**
+ * Returns changesets recorded by this pool, or `null` if the pool doesn't support recording them.
+ */
+@OptIn(ExperimentalPowerSyncAPI::class)
+internal fun SQLiteConnectionPool.recordedRowChanges(): SharedFlow<RowChangeset>? =
+    (this as? RowChangeSource)?.rowChanges
+
+/**
+ * Records a [RowChangeset] for each write on [connection] while [rowChanges] has subscribers.
+ *
+ * Recording changes has a cost for every write, so the underlying session is only kept open while
+ * someone is listening. All methods must be called while holding exclusive access to the
+ * connection.
+ */
+@OptIn(ExperimentalPowerSyncAPI::class)
+internal class RowChangeRecorder(
+    private val connection: SessionRecordingConnection,
+) {
+    // Changesets must be delivered in the order they were committed, so we can't emit them from
+    // independent coroutines. Buffering them allows emitting without suspending the writer.
+    private val changesets = MutableSharedFlow<RowChangeset>(extraBufferCapacity = Channel.UNLIMITED)
+    private var session: ChangesetSession? = null
+
+    val rowChanges: SharedFlow<RowChangeset>
+        get() = changesets
+
+    fun beforeWrite() {
+        val hasSubscribers = changesets.subscriptionCount.value > 0
+        val active = session
+
+        if (hasSubscribers && active == null) {
+            session = connection.openChangesetSession()
+        } else if (!hasSubscribers && active != null) {
+            active.close()
+            session = null
+        }
+    }
+
+    /**
+     * Emits the changes recorded during a write.
+     *
+     * This is also called after failed writes: statements outside of a transaction have been
+     * committed regardless, and changesets are built from the current contents of changed rows, so
+     * changes that have been rolled back aren't part of them.
+     */
+    fun afterWrite() {
+        val active = session ?: return
+        val changeset = active.changeset() ?: return
+
+        // Sessions accumulate changes until they're deleted, so start a fresh one for the next
+        // write.
+        active.close()
+        session = null
+        session = connection.openChangesetSession()
+        changesets.tryEmit(RowChangeset(changeset))
+    }
+
+    fun close() {
+        session?.close()
+        session = null
+    }
+}
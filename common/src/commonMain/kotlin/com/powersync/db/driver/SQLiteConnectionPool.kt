@@ -48,6 +48,25 @@ public interface SQLiteConnectionPool {
     public suspend fun close()
 }
 
+/**
+ * Implemented by connection pools on which [SQLiteConnectionPool.write] reuses a write lease already
+ * held by the calling coroutine instead of waiting for the write connection.
+ */
+@ExperimentalPowerSyncAPI
+public interface ReentrantWritePool {
+    /**
+     * Whether the calling coroutine holds a write lease of this pool.
+     */
+    public suspend fun isInWrite(): Boolean
+}
+
+/**
+ * Returns whether the calling coroutine holds a write lease that writes on this pool would reuse.
+ */
+@OptIn(ExperimentalPowerSyncAPI::class)
+internal suspend fun SQLiteConnectionPool.isInReentrantWrite(): Boolean =
+    (this as? ReentrantWritePool)?.isInWrite() == true
+
 public interface SQLiteConnectionLease {
     /**
      * Queries the autocommit state on the connection.
@@ -74,6 +93,21 @@ public interface SQLiteConnectionLease {
             usePrepared(sql, block)
         }
 
+    /**
+     * Like [usePrepared], but allows the pool to keep the statement prepared for [key] on the
+     * underlying connection so that later leases can reuse it.
+     *
+     * Cached statements are reset and have their bindings cleared after [block] returns. If [key]
+     * was previously used with a different [sql] string, the statement is prepared again. Pools
+     * that don't cache statements prepare [sql] on every call.
+     */
+    @ExperimentalPowerSyncAPI
+    public suspend fun <R> usePreparedCached(
+        key: Any,
+        sql: String,
+        block: (SQLiteStatement) -> R,
+    ): R = usePrepared(sql, block)
+
     public suspend fun execSQL(sql: String) {
         usePrepared(sql) {
             it.step()
@@ -0,0 +1,22 @@
+package com.powersync.db.driver
+
+/**
+ * Implemented by connection pools that need to be told about schema changes made on their write
+ * connection, e.g. to refresh the schema of read connections before they're used again.
+ */
+internal interface SchemaAwarePool {
+    /**
+     * Called after the schema has been changed on the write connection, while still holding it.
+     */
+    fun onSchemaChanged()
+}
+
+/**
+ * Notifies this pool about a schema change, if it implements [SchemaAwarePool].
+ *
+ * Other pools are expected to handle schema changes themselves. SQLite reloads outdated schemas
+ * when preparing statements.
+ */
+internal fun SQLiteConnectionPool.notifySchemaChanged() {
+    (this as? SchemaAwarePool)?.onSchemaChanged()
+}
@@ -2,6 +2,7 @@ package com.powersync.db.driver
 
 import androidx.sqlite.SQLiteConnection
 import com.powersync.ExperimentalPowerSyncAPI
+import com.powersync.db.RowChangeset
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.IO
 import kotlinx.coroutines.flow.MutableSharedFlow
@@ -18,10 +19,13 @@ import kotlinx.coroutines.withContext
 @OptIn(ExperimentalPowerSyncAPI::class)
 public class SingleConnectionPool(
     private val conn: SQLiteConnection,
-) : SQLiteConnectionPool {
+) : SQLiteConnectionPool,
+    RowChangeSource {
     private val mutex: Mutex = Mutex()
     private var closed = false
+    private val statements = StatementCache()
     private val tableUpdatesFlow = MutableSharedFlow<Set<String>>(replay = 0)
+    private val rowChangeRecorder = (conn as? SessionRecordingConnection)?.let(::RowChangeRecorder)
 
     private val dispatcher = Dispatchers.IO
 
@@ -36,13 +40,16 @@ public class SingleConnectionPool(
             withContext(dispatcher) {
                 check(!closed) { "Connection closed" }
 
+                rowChangeRecorder?.beforeWrite()
                 try {
-                    callback(RawConnectionLease(conn))
+                    callback(RawConnectionLease(conn, statements))
                 } finally {
                     val updates = conn.readPendingUpdates()
                     if (updates.isNotEmpty()) {
                         tableUpdatesFlow.emit(updates)
                     }
+
+                    rowChangeRecorder?.afterWrite()
                 }
             }
         }
@@ -57,8 +64,13 @@ public class SingleConnectionPool(
     override val updates: SharedFlow<Set<String>>
         get() = tableUpdatesFlow
 
+    override val rowChanges: SharedFlow<RowChangeset>?
+        get() = rowChangeRecorder?.rowChanges
+
     override suspend fun close() {
         mutex.withLock {
+            rowChangeRecorder?.close()
+            statements.clear()
             conn.close()
         }
     }
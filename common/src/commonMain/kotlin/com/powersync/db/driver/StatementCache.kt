@@ -0,0 +1,79 @@
+package com.powersync.db.driver
+
+import androidx.sqlite.SQLiteConnection
+import androidx.sqlite.SQLiteStatement
+
+/**
+ * A least-recently-used cache of statements prepared on a single connection, keyed by caller-provided
+ * keys (like the query identifiers generated by SQLDelight).
+ *
+ * Statements are reset after each use. A statement is removed from the cache while it's in use, so
+ * that reentrant uses of the same key prepare a separate statement. Since the cache belongs to a
+ * connection, it must only be used while holding a lease on that connection.
+ */
+internal class StatementCache(
+    private val maxEntries: Int = DEFAULT_MAX_ENTRIES,
+) {
+    // In access order, so that the first entry is the least recently used one.
+    private val entries = LinkedHashMap<Any, CachedStatement>()
+
+    fun <R> use(
+        connection: SQLiteConnection,
+        key: Any,
+        sql: String,
+        block: (SQLiteStatement) -> R,
+    ): R {
+        val cached = entries.remove(key)
+        val statement =
+            if (cached != null && cached.sql == sql) {
+                cached.statement
+            } else {
+                // Keys are only unique per caller, so a different statement may use the same key.
+                cached?.statement?.close()
+                connection.prepare(sql)
+            }
+
+        var reusable = false
+        try {
+            val result = block(statement)
+            statement.reset()
+            statement.clearBindings()
+            reusable = true
+            return result
+        } finally {
+            if (reusable) {
+                put(key, CachedStatement(sql, statement))
+            } else {
+                statement.close()
+            }
+        }
+    }
+
+    private fun put(
+        key: Any,
+        statement: CachedStatement,
+    ) {
+        entries.put(key, statement)?.statement?.close()
+        if (entries.size > maxEntries) {
+            val eldest = entries.keys.first()
+            entries.remove(eldest)?.statement?.close()
+        }
+    }
+
+    /**
+     * Closes all cached statements, e.g. because the schema has changed.
+     */
+    fun clear() {
+        entries.values.forEach { it.statement.close() }
+        entries.clear()
+    }
+
+    private class CachedStatement(
+        val sql: String,
+        val statement: SQLiteStatement,
+    )
+
+    private companion object {
+        const val DEFAULT_MAX_ENTRIES = 32
+    }
+}
@@ -0,0 +1,174 @@
+package com.powersync.db.internal
+
+import com.powersync.ExperimentalPowerSyncAPI
+import com.powersync.db.driver.SQLiteConnectionLease
+import com.powersync.db.driver.SQLiteConnectionPool
+import io.ktor.utils.io.InternalAPI
+import io.ktor.utils.io.locks.SynchronizedObject
+import io.ktor.utils.io.locks.synchronized
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.launch
+import kotlin.time.Duration
+
+/**
+ * Coalesces independent [InternalDatabase.execute] calls into shared write transactions.
+ *
+ * Statements submitted within [window] of each other are executed in a single transaction, saving
+ * a commit (and an update notification) per statement. Each statement runs in its own savepoint,
+ * so a failing statement doesn't affect others in the same batch. Callers are only resumed once
+ * the transaction containing their statement has been committed.
+ */
+@OptIn(ExperimentalPowerSyncAPI::class, InternalAPI::class)
+internal class GroupCommitQueue(
+    private val pool: SQLiteConnectionPool,
+    private val scope: CoroutineScope,
+    private val window: Duration,
+) : SynchronizedObject() {
+    private var pending = mutableListOf<PendingWrite>()
+    private var flushScheduled = false
+
+    suspend fun execute(
+        sql: String,
+        parameters: List<Any?>?,
+    ): Long {
+        val write = PendingWrite(sql, parameters)
+        synchronized(this) {
+            pending.add(write)
+            if (!flushScheduled) {
+                flushScheduled = true
+                scope.launch { flushAfterWindow() }.invokeOnCompletion { cause ->
+                    // If the scope is cancelled before the batch was picked up, fail pending writes
+                    // instead of leaving their callers suspended forever.
+                    if (cause != null) failPending(cause)
+                }
+            }
+        }
+
+        try {
+            return write.result.await()
+        } catch (e: CancellationException) {
+            // If the statement hasn't been picked up by a batch yet, don't run it at all.
+            synchronized(this) { pending.remove(write) }
+            throw e
+        }
+    }
+
+    private fun failPending(cause: Throwable) {
+        val batch =
+            synchronized(this) {
+                flushScheduled = false
+                pending.also { pending = mutableListOf() }
+            }
+
+        batch.forEach { it.result.completeExceptionally(cause) }
+    }
+
+    private suspend fun flushAfterWindow() {
+        delay(window)
+
+        val batch =
+            synchronized(this) {
+                flushScheduled = false
+                pending.also { pending = mutableListOf() }
+            }
+
+        if (batch.isEmpty()) {
+            return
+        }
+
+        try {
+            pool.write { lease -> runBatch(lease, batch) }
+        } catch (e: Throwable) {
+            // Failing to begin or commit the transaction fails all statements that haven't
+            // completed yet.
+            batch.forEach { it.result.completeExceptionally(e) }
+        }
+    }
+
+    private suspend fun runBatch(
+        lease: SQLiteConnectionLease,
+        batch: List<PendingWrite>,
+    ) {
+        var remaining = batch
+        while (remaining.isNotEmpty()) {
+            // Some errors (like a trigger raising ROLLBACK) abort the entire transaction instead of
+            // the statement. In that case, we report the error to the statement causing it and
+            // re-run the others in a new transaction.
+            val outcome = runTransaction(lease, remaining)
+            if (outcome.abortedAt == null) {
+                remaining.zip(outcome.results).forEach { (write, result) ->
+                    write.result.completeWith(result)
+                }
+                return
+            }
+
+            val failed = remaining[outcome.abortedAt]
+            failed.result.completeExceptionally(outcome.results[outcome.abortedAt].exceptionOrNull()!!)
+            remaining = remaining - failed
+        }
+    }
+
+    private suspend fun runTransaction(
+        lease: SQLiteConnectionLease,
+        writes: List<PendingWrite>,
+    ): BatchOutcome {
+        val context = ConnectionContextImplementation(lease)
+        val results = mutableListOf<Result<Long>>()
+
+        lease.execSQL("BEGIN")
+        try {
+            for (write in writes) {
+                lease.execSQL("SAVEPOINT $SAVEPOINT")
+                val result =
+                    try {
+                        Result.success(context.execute(write.sql, write.parameters))
+                    } catch (e: CancellationException) {
+                        throw e
+                    } catch (e: Throwable) {
+                        Result.failure(e)
+                    }
+                results.add(result)
+
+                if (!lease.isInTransaction()) {
+                    // The statement failed and rolled back the transaction.
+                    return BatchOutcome(results, abortedAt = results.lastIndex)
+                }
+
+                if (result.isFailure) {
+                    lease.execSQL("ROLLBACK TO $SAVEPOINT")
+                }
+                lease.execSQL("RELEASE $SAVEPOINT")
+            }
+
+            lease.execSQL("COMMIT")
+            return BatchOutcome(results, abortedAt = null)
+        } catch (e: Throwable) {
+            // Don't return the connection to the pool with an open transaction (e.g. because COMMIT
+            // failed with a deferred constraint violation or the batch was cancelled).
+            if (lease.isInTransaction()) {
+                lease.execSQL("ROLLBACK")
+            }
+
+            throw e
+        }
+    }
+
+    private class PendingWrite(
+        val sql: String,
+        val parameters: List<Any?>?,
+    ) {
+        val result = CompletableDeferred<Long>()
+    }
+
+    private class BatchOutcome(
+        val results: List<Result<Long>>,
+        val abortedAt: Int?,
+    )
+
+    private companion object {
+        const val SAVEPOINT = "powersync_group_commit"
+    }
+}
@@ -2,53 +2,88 @@ package com.powersync.db.internal
 
 import co.touchlab.kermit.Logger
 import com.powersync.ExperimentalPowerSyncAPI
+import com.powersync.PowerSyncException
+import com.powersync.db.QueryDiff
+import com.powersync.db.RowChangeset
 import com.powersync.db.SqlCursor
 import com.powersync.db.ThrowableLockCallback
 import com.powersync.db.ThrowableTransactionCallback
+import com.powersync.db.driver.ReadPriority
 import com.powersync.db.driver.SQLiteConnectionLease
 import com.powersync.db.driver.SQLiteConnectionPool
+import com.powersync.db.driver.clearCachedStatements
+import com.powersync.db.driver.isInReentrantWrite
+import com.powersync.db.driver.notifySchemaChanged
+import com.powersync.db.driver.recordedRowChanges
 import com.powersync.db.runWrapped
-import com.powersync.utils.AtomicMutableSet
 import com.powersync.utils.JsonUtil
+import com.powersync.utils.TimerWheel
 import com.powersync.utils.throttle
+import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.flow.Flow
 import kotlinx.coroutines.flow.SharedFlow
 import kotlinx.coroutines.flow.emitAll
 import kotlinx.coroutines.flow.flow
 import kotlinx.coroutines.flow.map
-import kotlinx.coroutines.flow.onSubscription
-import kotlinx.coroutines.flow.transform
+import kotlinx.coroutines.flow.mapNotNull
+import kotlinx.coroutines.withContext
+import kotlin.time.Duration
 import kotlin.time.Duration.Companion.milliseconds
 
 @OptIn(ExperimentalPowerSyncAPI::class)
 internal class InternalDatabaseImpl(
     private val pool: SQLiteConnectionPool,
     private val logger: Logger,
+    scope: CoroutineScope,
+    groupCommitWindow: Duration = Duration.ZERO,
 ) : InternalDatabase {
+    private val groupCommit =
+        if (groupCommitWindow.isPositive()) {
+            GroupCommitQueue(pool, scope, groupCommitWindow)
+        } else {
+            null
+        }
+
+    private val sharedWatches = SharedWatchQueries(scope)
+    private val sourceTables = SourceTableCache()
+
+    // Resolving pool.updates lazily avoids opening a LazyPool when the database is constructed.
+    private val tableUpdates = TableUpdateDispatcher(flow { emitAll(pool.updates) }, scope)
+    private val throttleTimers = TimerWheel(scope)
+
     override suspend fun execute(
         sql: String,
         parameters: List<Any?>?,
-    ): Long =
-        writeLock { context ->
+    ): Long {
+        // Batches are written from the database scope, where they would wait for a write lease held
+        // by the caller.
+        if (groupCommit != null && !pool.isInReentrantWrite()) {
+            return runWrapped { groupCommit.execute(sql, parameters) }
+        }
+
+        return writeLock { context ->
             context.execute(sql, parameters)
         }
+    }
 
     override suspend fun updateSchema(schemaJson: String) {
         runWrapped {
-            pool.withAllConnections { writer, readers ->
+            // Only the writer is needed: read connections pick up the new schema when they're
+            // leased next, so reads in progress aren't blocked by the schema change.
+            pool.write { writer ->
                 writer.runTransaction { tx ->
                     tx.getOptional(
                         "SELECT powersync_replace_schema(?);",
                         listOf(schemaJson),
                     ) {}
                 }
-
-                // Update the schema on all read connections
-                for (readConnection in readers) {
-                    readConnection.execSQL("pragma table_info('sqlite_master')")
-                }
+                writer.clearCachedStatements()
+                pool.notifySchemaChanged()
             }
         }
+
+        // Views may now resolve to different tables.
+        sourceTables.invalidate()
     }
 
     override suspend fun <RowType : Any> get(
@@ -74,12 +109,35 @@ internal class InternalDatabaseImpl(
         throttleMs: Long,
         triggerImmediately: Boolean,
     ): Flow<Set<String>> {
+        // Match all possible internal table combinations, and map them back to the table name.
+        val friendlyNames =
+            buildMap {
+                for (table in tables) {
+                    put(table, table)
+                    put("ps_data__$table", table)
+                    put("ps_data_local__$table", table)
+                }
+            }
+
+        return rawChangedTables(friendlyNames.keys, throttleMs, triggerImmediately).map { changed ->
+            changed.mapTo(mutableSetOf()) { friendlyNames.getValue(it) }
+        }
+    }
+
+    fun rowChanges(tables: Set<String>): Flow<RowChangeset> {
         // Match all possible internal table combinations
         val watchedTables =
             tables.flatMap { listOf(it, "ps_data__$it", "ps_data_local__$it") }.toSet()
 
-        return rawChangedTables(watchedTables, throttleMs, triggerImmediately).map {
-            it.mapTo(mutableSetOf(), ::friendlyTableName)
+        return flow {
+            val changesets =
+                pool.recordedRowChanges()
+                    ?: throw PowerSyncException(
+                        "The connection pool does not support recording row changes",
+                        cause = null,
+                    )
+
+            emitAll(changesets.mapNotNull { it.filterTables(watchedTables) })
         }
     }
 
@@ -89,6 +147,35 @@ internal class InternalDatabaseImpl(
         throttleMs: Long,
         mapper: (SqlCursor) -> RowType,
     ): Flow<List<RowType>> =
+        // Subscribers watching the same query share its execution, only the mapper runs for each
+        // of them.
+        sharedWatches
+            .watch(SharedWatchQueries.Key(sql, parameters, throttleMs)) {
+                watchRows(sql, parameters, throttleMs)
+            }.map { rows -> runWrapped { rows.map(mapper) } }
+
+    fun <RowType : Any> watchDiff(
+        sql: String,
+        parameters: List<Any?>?,
+        keyColumn: String,
+        throttleMs: Long,
+        mapper: (SqlCursor) -> RowType,
+    ): Flow<QueryDiff<RowType>> =
+        flow {
+            val differ = QueryDiffer(keyColumn, mapper)
+            val results =
+                sharedWatches.watch(SharedWatchQueries.Key(sql, parameters, throttleMs)) {
+                    watchRows(sql, parameters, throttleMs)
+                }
+
+            emitAll(results.map { rows -> runWrapped { differ.apply(rows) } })
+        }
+
+    private fun watchRows(
+        sql: String,
+        parameters: List<Any?>?,
+        throttleMs: Long,
+    ): Flow<MaterializedRows> =
         flow {
             // Fetch the tables asynchronously with getAll
             val tables =
@@ -99,7 +186,16 @@ internal class InternalDatabaseImpl(
             val queries =
                 rawChangedTables(tables, throttleMs, triggerImmediately = true).map {
                     logger.v { "Fetching watch() query: $sql" }
-                    val rows = getAll(sql, parameters = parameters, mapper = mapper)
+                    // Re-running watched queries shouldn't delay reads awaited by users.
+                    val rows =
+                        withContext(ReadPriority.BACKGROUND) {
+                            internalReadLock { connection ->
+                                connection.usePrepared(sql) { stmt ->
+                                    stmt.bind(parameters)
+                                    MaterializedRows.read(stmt)
+                                }
+                            }
+                        }
                     logger.v { "watch query $sql done, emitting downstream" }
                     rows
                 }
@@ -112,36 +208,27 @@ internal class InternalDatabaseImpl(
         triggerImmediately: Boolean,
     ): Flow<Set<String>> =
         flow {
-            val batchedUpdates = AtomicMutableSet<String>()
+            val subscription = tableUpdates.subscribe(tableNames)
+            try {
+                if (triggerImmediately) {
+                    // Emit an initial event (if requested). No changes would be detected at this point
+                    subscription.wakeUp()
+                }
 
-            updatesOnTables()
-                .onSubscription {
-                    if (triggerImmediately) {
-                        // Emit an initial event (if requested). No changes would be detected at this point
-                        emit(initialUpdateSentinel)
-                    }
-                }.transform { updates ->
-                    if (updates === initialUpdateSentinel) {
-                        // This should always be emitted despite being empty and not intersecting with
-                        // the tables we care about.
-                        emit(Unit)
-                    } else {
-                        val intersection = updates.intersect(tableNames)
-                        if (intersection.isNotEmpty()) {
-                            batchedUpdates.addAll(intersection)
-                            emit(Unit)
-                        }
+                subscription.wakeups
+                    // Throttling here is a feature which prevents watch queries from spamming updates.
+                    // Throttling by design discards and delays events within the throttle window. Discarded events
+                    // still trigger a trailing edge update.
+                    // Backpressure is avoided on the throttling and consumer level by conflating wakeups.
+                    // Pauses are scheduled on a timer wheel shared by all flows, which aligns trailing edges
+                    // of flows that were woken up by the same write.
+                    .throttle(throttleMs.milliseconds, throttleTimers)
+                    .collect {
+                        emit(subscription.takeChangedTables())
                     }
-                }
-                // Throttling here is a feature which prevents watch queries from spamming updates.
-                // Throttling by design discards and delays events within the throttle window. Discarded events
-                // still trigger a trailing edge update.
-                // Backpressure is avoided on the throttling and consumer level by buffering the last upstream value.
-                .throttle(throttleMs.milliseconds)
-                .collect {
-                    val entries = batchedUpdates.toSetAndClear()
-                    emit(entries)
-                }
+            } finally {
+                subscription.close()
+            }
         }
 
     override suspend fun <T> useConnection(
@@ -203,66 +290,50 @@ internal class InternalDatabaseImpl(
     private suspend fun getSourceTables(
         sql: String,
         parameters: List<Any?>?,
-    ): Set<String> {
-        val rows =
-            getAll(
-                "EXPLAIN $sql",
-                parameters = parameters,
-                mapper = {
-                    ExplainQueryResult(
-                        addr = it.getString(0)!!,
-                        opcode = it.getString(1)!!,
-                        p1 = it.getLong(2)!!,
-                        p2 = it.getLong(3)!!,
-                        p3 = it.getLong(4)!!,
-                    )
-                },
-            )
+    ): Set<String> =
+        internalReadLock { connection ->
+            val schemaVersion =
+                connection.usePrepared("PRAGMA schema_version") {
+                    check(it.step())
+                    it.getLong(0)
+                }
+            sourceTables.get(sql, schemaVersion)?.let { return@internalReadLock it }
 
-        val rootPages = mutableListOf<Long>()
-        for (row in rows) {
-            if ((row.opcode == "OpenRead" || row.opcode == "OpenWrite") && row.p3 == 0L && row.p2 != 0L) {
-                rootPages.add(row.p2)
-            }
+            // Find root pages of tables opened by the statement, reading only the columns we need
+            // from the EXPLAIN output (opcode, p2 and p3).
+            val rootPages =
+                connection.usePrepared("EXPLAIN $sql") { stmt ->
+                    stmt.bind(parameters)
+                    buildList {
+                        while (stmt.step()) {
+                            val opcode = stmt.getText(1)
+                            val p2 = stmt.getLong(3)
+                            if ((opcode == "OpenRead" || opcode == "OpenWrite") && stmt.getLong(4) == 0L && p2 != 0L) {
+                                add(p2)
+                            }
+                        }
+                    }
+                }
+
+            val tables =
+                connection.usePrepared(
+                    "SELECT tbl_name FROM sqlite_master WHERE rootpage IN (SELECT json_each.value FROM json_each(?))",
+                ) { stmt ->
+                    stmt.bindText(1, JsonUtil.json.encodeToString(rootPages))
+                    buildSet {
+                        while (stmt.step()) {
+                            add(stmt.getText(0))
+                        }
+                    }
+                }
+
+            sourceTables.put(sql, schemaVersion, tables)
+            tables
         }
-        val params = listOf(JsonUtil.json.encodeToString(rootPages))
-        val tableRows =
-            getAll(
-                "SELECT tbl_name FROM sqlite_master WHERE rootpage IN (SELECT json_each.value FROM json_each(?))",
-                parameters = params,
-                mapper = { it.getString(0)!! },
-            )
-
-        return tableRows.toSet()
-    }
 
     override suspend fun close() {
         runWrapped {
             pool.close()
         }
     }
-
-    internal data class ExplainQueryResult(
-        val addr: String,
-        val opcode: String,
-        val p1: Long,
-        val p2: Long,
-        val p3: Long,
-    )
-
-    private companion object {
-        val initialUpdateSentinel = emptySet<String>()
-    }
-}
-
-/**
- * Converts internal table names (e.g., prefixed with "ps_data__" or "ps_data_local__")
- * to their original friendly names by removing the prefixes. If no prefix matches,
- * the original table name is returned.
- */
-private fun friendlyTableName(table: String): String {
-    val re = Regex("^ps_data__(.+)$")
-    val re2 = Regex("^ps_data_local__(.+)$")
-    val match = re.matchEntire(table) ?: re2.matchEntire(table)
-    return match?.groupValues?.get(1) ?: table
 }
@@ -0,0 +1,131 @@
+package com.powersync.db.internal
+
+import androidx.sqlite.SQLiteStatement
+import com.powersync.db.SqlCursor
+import com.powersync.db.columnIndices
+
+/**
+ * The result set of a query, copied out of the statement so that it can be mapped multiple times
+ * (and by different mappers) after the statement has been closed.
+ *
+ * Values are stored with their SQLite storage class, as [Long], [Double], [String], [ByteArray]
+ * or `null`. Reading values with a different type applies the same conversions SQLite would, see
+ * [SqliteConversions].
+ */
+internal class MaterializedRows(
+    val columns: List<String>,
+    val rows: List<Array<Any?>>,
+) {
+    private val indicesByName by lazy { columnIndices(columns) }
+
+    fun <RowType : Any> map(mapper: (SqlCursor) -> RowType): List<RowType> {
+        val cursor = RowCursor()
+        return rows.indices.map { index ->
+            cursor.moveTo(index)
+            mapper(cursor)
+        }
+    }
+
+    /**
+     * Maps the row at [index] in [rows].
+     */
+    fun <RowType : Any> mapRow(
+        index: Int,
+        mapper: (SqlCursor) -> RowType,
+    ): RowType = mapper(RowCursor().also { it.moveTo(index) })
+
+    /**
+     * Returns the index of the column [name], or null if no such column exists.
+     */
+    fun columnIndex(name: String): Int? = indicesByName[name]
+
+    private inner class RowCursor : SqlCursor {
+        private lateinit var row: Array<Any?>
+
+        fun moveTo(index: Int) {
+            row = rows[index]
+        }
+
+        override fun getBoolean(index: Int): Boolean? = getLong(index)?.let { it != 0L }
+
+        override fun getBytes(index: Int): ByteArray? =
+            when (val value = row[index]) {
+                null -> null
+                is ByteArray -> value
+                else -> getString(index)!!.encodeToByteArray()
+            }
+
+        override fun getDouble(index: Int): Double? =
+            when (val value = row[index]) {
+                null -> null
+                is Double -> value
+                // Matches SQLite, which casts integers to doubles.
+                is Long -> value.toDouble()
+                is String -> SqliteConversions.textToDouble(value)
+                is ByteArray -> SqliteConversions.textToDouble(value.decodeToString())
+                else -> error("Unexpected value $value")
+            }
+
+        override fun getLong(index: Int): Long? =
+            when (val value = row[index]) {
+                null -> null
+                is Long -> value
+                // Kotlin clamps out-of-range values like SQLite does.
+                is Double -> value.toLong()
+                is String -> SqliteConversions.textToLong(value)
+                is ByteArray -> SqliteConversions.textToLong(value.decodeToString())
+                else -> error("Unexpected value $value")
+            }
+
+        override fun getString(index: Int): String? =
+            when (val value = row[index]) {
+                null -> null
+                is String -> value
+                // Matches SQLite, which formats integers with %lld.
+                is Long -> value.toString()
+                is Double -> SqliteConversions.realToText(value)
+                is ByteArray -> value.decodeToString()
+                else -> error("Unexpected value $value")
+            }
+
+        override fun columnName(index: Int): String? = columns[index]
+
+        override val columnCount: Int
+            get() = columns.size
+
+        override val columnNames: Map<String, Int>
+            get() = indicesByName
+    }
+
+    companion object {
+        // Fundamental SQLite datatypes, as returned by SQLiteStatement.getColumnType
+        private const val SQLITE_INTEGER = 1
+        private const val SQLITE_FLOAT = 2
+        private const val SQLITE_BLOB = 4
+        private const val SQLITE_NULL = 5
+
+        /**
+         * Steps through [stmt] and copies all of its rows.
+         */
+        fun read(stmt: SQLiteStatement): MaterializedRows {
+            val columnCount = stmt.getColumnCount()
+            val rows = mutableListOf<Array<Any?>>()
+
+            while (stmt.step()) {
+                rows.add(
+                    Array(columnCount) { index ->
+                        when (stmt.getColumnType(index)) {
+                            SQLITE_NULL -> null
+                            SQLITE_INTEGER -> stmt.getLong(index)
+                            SQLITE_FLOAT -> stmt.getDouble(index)
+                            SQLITE_BLOB -> stmt.getBlob(index)
+                            else -> stmt.getText(index)
+                        }
+                    },
+                )
+            }
+
+            return MaterializedRows(stmt.getColumnNames(), rows)
+        }
+    }
+}
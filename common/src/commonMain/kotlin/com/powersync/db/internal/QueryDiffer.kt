@@ -0,0 +1,146 @@
+package com.powersync.db.internal
+
+import com.powersync.ExperimentalPowerSyncAPI
+import com.powersync.PowerSyncException
+import com.powersync.db.QueryDiff
+import com.powersync.db.RowDiff
+import com.powersync.db.SqlCursor
+
+/**
+ * Computes [QueryDiff]s between consecutive results of a watched query.
+ *
+ * Rows are matched by the value of [keyColumn]. Raw column values of the previous result are kept
+ * so that rows can be compared without mapping them, [mapper] only runs for new or changed rows.
+ */
+@OptIn(ExperimentalPowerSyncAPI::class)
+internal class QueryDiffer<RowType : Any>(
+    private val keyColumn: String,
+    private val mapper: (SqlCursor) -> RowType,
+) {
+    private var previous: List<Entry<RowType>> = emptyList()
+    private var previousIndices: Map<Any, Int> = emptyMap()
+
+    fun apply(result: MaterializedRows): QueryDiff<RowType> {
+        val keyIndex =
+            result.columnIndex(keyColumn)
+                ?: throw PowerSyncException("watchDiff() key column '$keyColumn' is not part of the result", null)
+
+        val entries = ArrayList<Entry<RowType>>(result.rows.size)
+        val indices = HashMap<Any, Int>(result.rows.size)
+        // For each row in the new result, its index in the previous result or -1 if it's new.
+        val previousIndexOf = IntArray(result.rows.size)
+        val updated = BooleanArray(result.rows.size)
+
+        result.rows.forEachIndexed { index, values ->
+            val key =
+                rowKey(values[keyIndex])
+                    ?: throw PowerSyncException("watchDiff() key column '$keyColumn' must not be null", null)
+            if (indices.put(key, index) != null) {
+                throw PowerSyncException("watchDiff() key column '$keyColumn' must be unique, found $key twice", null)
+            }
+
+            val hash = values.contentDeepHashCode()
+            val previousIndex = previousIndices[key] ?: -1
+            val old = if (previousIndex >= 0) previous[previousIndex] else null
+            previousIndexOf[index] = previousIndex
+
+            entries +=
+                if (old != null && old.hash == hash && old.values.contentDeepEquals(values)) {
+                    old
+                } else {
+                    updated[index] = old != null
+                    Entry(values, hash, result.mapRow(index, mapper))
+                }
+        }
+
+        val changes = mutableListOf<RowDiff<RowType>>()
+        previous.forEachIndexed { index, entry ->
+            val key = rowKey(entry.values[keyIndex])
+            if (key == null || key !in indices) {
+                changes += RowDiff.Removed(index, entry.row)
+            }
+        }
+
+        val stationary = stationaryRows(previousIndexOf)
+        entries.forEachIndexed { index, entry ->
+            val previousIndex = previousIndexOf[index]
+            if (previousIndex < 0) {
+                changes += RowDiff.Inserted(index, entry.row)
+            } else {
+                if (!stationary[index]) {
+                    changes += RowDiff.Moved(previousIndex, index, entry.row)
+                }
+                if (updated[index]) {
+                    changes += RowDiff.Updated(index, previous[previousIndex].row, entry.row)
+                }
+            }
+        }
+
+        previous = entries
+        previousIndices = indices
+        return QueryDiff(entries.map { it.row }, changes)
+    }
+
+    private class Entry<RowType : Any>(
+        val values: Array<Any?>,
+        val hash: Int,
+        val row: RowType,
+    )
+
+    private companion object {
+        /**
+         * Returns a key with value semantics for a raw column value, or null for null values.
+         */
+        fun rowKey(value: Any?): Any? =
+            when (value) {
+                is ByteArray -> BlobKey(value)
+                else -> value
+            }
+
+        /**
+         * Marks rows that kept their relative order, which is the longest increasing subsequence of
+         * previous indices. All other retained rows are reported as moved.
+         */
+        fun stationaryRows(previousIndexOf: IntArray): BooleanArray {
+            // Patience sorting: tails[k] is the index of the smallest tail of an increasing
+            // subsequence of length k + 1.
+            val tails = IntArray(previousIndexOf.size)
+            val predecessor = IntArray(previousIndexOf.size) { -1 }
+            var length = 0
+
+            for (i in previousIndexOf.indices) {
+                val value = previousIndexOf[i]
+                if (value < 0) continue
+
+                var low = 0
+                var high = length
+                while (low < high) {
+                    val mid = (low + high) ushr 1
+                    if (previousIndexOf[tails[mid]] < value) low = mid + 1 else high = mid
+                }
+
+                if (low > 0) predecessor[i] = tails[low - 1]
+                tails[low] = i
+                if (low == length) length++
+            }
+
+            val stationary = BooleanArray(previousIndexOf.size)
+            var current = if (length > 0) tails[length - 1] else -1
+            while (current >= 0) {
+                stationary[current] = true
+                current = predecessor[current]
+            }
+            return stationary
+        }
+    }
+
+    private class BlobKey(
+        val bytes: ByteArray,
+    ) {
+        override fun equals(other: Any?): Boolean = other is BlobKey && bytes.contentEquals(other.bytes)
+
+        override fun hashCode(): Int = bytes.contentHashCode()
+
+        override fun toString(): String = "blob(${bytes.size} bytes)"
+    }
+}
@@ -0,0 +1,88 @@
+package com.powersync.db.internal
+
+import io.ktor.utils.io.InternalAPI
+import io.ktor.utils.io.locks.SynchronizedObject
+import io.ktor.utils.io.locks.synchronized
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.SharedFlow
+import kotlinx.coroutines.flow.SharingStarted
+import kotlinx.coroutines.flow.catch
+import kotlinx.coroutines.flow.emitAll
+import kotlinx.coroutines.flow.flow
+import kotlinx.coroutines.flow.map
+import kotlinx.coroutines.flow.shareIn
+
+/**
+ * Shares the execution of watched queries between all subscribers watching the same query.
+ *
+ * The first subscriber for a [Key] starts the upstream flow in [scope]. Later subscribers receive
+ * the latest result immediately and follow subsequent results without running the query again.
+ * The upstream is cancelled once the last subscriber stops collecting.
+ */
+@OptIn(InternalAPI::class)
+internal class SharedWatchQueries(
+    private val scope: CoroutineScope,
+) : SynchronizedObject() {
+    private val active = mutableMapOf<Key, Entry>()
+
+    fun watch(
+        key: Key,
+        upstream: () -> Flow<MaterializedRows>,
+    ): Flow<MaterializedRows> =
+        flow {
+            val entry = acquire(key, upstream)
+            try {
+                emitAll(entry.results.map { it.getOrThrow() })
+            } finally {
+                release(key, entry)
+            }
+        }
+
+    private fun acquire(
+        key: Key,
+        upstream: () -> Flow<MaterializedRows>,
+    ): Entry =
+        synchronized(this) {
+            val entry =
+                active.getOrPut(key) {
+                    // Errors can't be thrown across a shared flow, so we forward them as values to
+                    // all subscribers.
+                    val results =
+                        upstream()
+                            .map { Result.success(it) }
+                            .catch { emit(Result.failure(it)) }
+                            .shareIn(scope, SharingStarted.WhileSubscribed(), replay = 1)
+                    Entry(results)
+                }
+
+            entry.subscribers++
+            entry
+        }
+
+    private fun release(
+        key: Key,
+        entry: Entry,
+    ) {
+        synchronized(this) {
+            if (--entry.subscribers == 0 && active[key] === entry) {
+                active.remove(key)
+            }
+        }
+    }
+
+    /**
+     * Identifies watched queries that can share their execution.
+     */
+    data class Key(
+        val sql: String,
+        val parameters: List<Any?>?,
+        val throttleMs: Long,
+    )
+
+    private class Entry(
+        val results: SharedFlow<Result<MaterializedRows>>,
+    ) {
+        var subscribers = 0
+    }
+}
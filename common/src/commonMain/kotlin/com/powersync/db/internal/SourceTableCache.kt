@@ -0,0 +1,65 @@
+package com.powersync.db.internal
+
+import io.ktor.utils.io.InternalAPI
+import io.ktor.utils.io.locks.SynchronizedObject
+import io.ktor.utils.io.locks.synchronized
+
+/**
+ * Caches the tables a watched query reads from, so that subscribing to the same query again
+ * doesn't have to inspect its bytecode.
+ *
+ * Entries are tied to the SQLite schema version they were resolved with (`PRAGMA schema_version`)
+ * and are discarded once it changes. [invalidate] clears the cache explicitly, which is used when
+ * the PowerSync schema is replaced.
+ */
+@OptIn(InternalAPI::class)
+internal class SourceTableCache(
+    private val maxEntries: Int = DEFAULT_MAX_ENTRIES,
+) : SynchronizedObject() {
+    private var schemaVersion: Long? = null
+
+    // In insertion order, so that the first entry is the oldest.
+    private val entries = LinkedHashMap<String, Set<String>>()
+
+    fun get(
+        sql: String,
+        schemaVersion: Long,
+    ): Set<String>? =
+        synchronized(this) {
+            if (schemaVersion != this.schemaVersion) {
+                null
+            } else {
+                entries[sql]
+            }
+        }
+
+    fun put(
+        sql: String,
+        schemaVersion: Long,
+        tables: Set<String>,
+    ) {
+        synchronized(this) {
+            if (schemaVersion != this.schemaVersion) {
+                entries.clear()
+                this.schemaVersion = schemaVersion
+            }
+
+            entries.remove(sql)
+            entries[sql] = tables
+            if (entries.size > maxEntries) {
+                entries.remove(entries.keys.first())
+            }
+        }
+    }
+
+    fun invalidate() {
+        synchronized(this) {
+            schemaVersion = null
+            entries.clear()
+        }
+    }
+
+    private companion object {
+        const val DEFAULT_MAX_ENTRIES = 256
+    }
+}
@@ -0,0 +1,174 @@
+package com.powersync.db.internal
+
+/**
+ * The conversions SQLite applies when a value is read with a different type than its storage
+ * class, for values that have been copied out of a statement.
+ */
+internal object SqliteConversions {
+    /**
+     * Parses the longest prefix of [text] that is an integer, like `sqlite3Atoi64`.
+     *
+     * Leading whitespace is skipped, values out of range are clamped and text without a numeric
+     * prefix is `0`.
+     */
+    fun textToLong(text: String): Long {
+        var position = skipWhitespace(text, 0)
+        var negative = false
+        if (position < text.length && (text[position] == '-' || text[position] == '+')) {
+            negative = text[position] == '-'
+            position++
+        }
+
+        // Accumulate the magnitude as a negative number, which can represent Long.MIN_VALUE.
+        var value = 0L
+        while (position < text.length && text[position].isAsciiDigit()) {
+            val digit = text[position] - '0'
+            if (value < (Long.MIN_VALUE + digit) / 10) {
+                return if (negative) Long.MIN_VALUE else Long.MAX_VALUE
+            }
+            value = value * 10 - digit
+            position++
+        }
+
+        return when {
+            negative -> value
+            value == Long.MIN_VALUE -> Long.MAX_VALUE
+            else -> -value
+        }
+    }
+
+    /**
+     * Parses the longest prefix of [text] that is a real number, like `sqlite3AtoF`.
+     *
+     * Text without a numeric prefix is `0.0`.
+     */
+    fun textToDouble(text: String): Double {
+        var position = skipWhitespace(text, 0)
+        val start = position
+        if (position < text.length && (text[position] == '-' || text[position] == '+')) {
+            position++
+        }
+
+        val integerStart = position
+        position = skipDigits(text, position)
+        val integerDigits = text.substring(integerStart, position)
+
+        var fractionDigits = ""
+        if (position < text.length && text[position] == '.') {
+            val fractionStart = position + 1
+            position = skipDigits(text, fractionStart)
+            fractionDigits = text.substring(fractionStart, position)
+        }
+
+        if (integerDigits.isEmpty() && fractionDigits.isEmpty()) {
+            return 0.0
+        }
+
+        var exponent = ""
+        if (position < text.length && (text[position] == 'e' || text[position] == 'E')) {
+            var exponentEnd = position + 1
+            if (exponentEnd < text.length && (text[exponentEnd] == '-' || text[exponentEnd] == '+')) {
+                exponentEnd++
+            }
+
+            val digitsEnd = skipDigits(text, exponentEnd)
+            // An exponent without digits isn't part of the number.
+            if (digitsEnd > exponentEnd) {
+                exponent = text.substring(position, digitsEnd)
+            }
+        }
+
+        val sign = if (text.getOrNull(start) == '-') "-" else ""
+        return "$sign${integerDigits.ifEmpty { "0" }}.${fractionDigits.ifEmpty { "0" }}$exponent".toDouble()
+    }
+
+    /**
+     * Formats [value] with 15 significant digits, like SQLite's `%!.15g` format used when reading
+     * reals as text.
+     */
+    fun realToText(value: Double): String {
+        when {
+            value.isNaN() -> return "NaN"
+            value.isInfinite() -> return if (value < 0) "-Inf" else "Inf"
+            value == 0.0 -> return "0.0"
+        }
+
+        // Start from the shortest representation of the value, which has at most 17 digits.
+        val shortest = if (value < 0) (-value).toString() else value.toString()
+        val exponentStart = shortest.indexOfFirst { it == 'e' || it == 'E' }
+        val mantissa = if (exponentStart == -1) shortest else shortest.substring(0, exponentStart)
+        val printedExponent = if (exponentStart == -1) 0 else shortest.substring(exponentStart + 1).toInt()
+
+        val point = mantissa.indexOf('.').takeIf { it != -1 } ?: mantissa.length
+        val allDigits = mantissa.removeRange(point, minOf(point + 1, mantissa.length))
+        val leadingZeros = allDigits.indexOfFirst { it != '0' }
+        var digits = allDigits.substring(leadingZeros)
+        // The exponent of the first digit in scientific notation.
+        var exponent = point - leadingZeros - 1 + printedExponent
+
+        if (digits.length > SIGNIFICANT_DIGITS) {
+            val roundUp = digits[SIGNIFICANT_DIGITS] >= '5'
+            digits = digits.substring(0, SIGNIFICANT_DIGITS)
+            if (roundUp) {
+                val rounded = digits.trimEnd('9')
+                digits =
+                    if (rounded.isEmpty()) {
+                        exponent++
+                        "1"
+                    } else {
+                        rounded.dropLast(1) + (rounded.last() + 1)
+                    }
+            }
+        }
+        digits = digits.trimEnd('0')
+
+        val formatted =
+            when {
+                exponent < -4 || exponent >= SIGNIFICANT_DIGITS -> {
+                    val exponentText = if (exponent < 0) (-exponent).toString() else exponent.toString()
+                    buildString {
+                        append(digits[0])
+                        append('.')
+                        append(digits.substring(1).ifEmpty { "0" })
+                        append(if (exponent < 0) "e-" else "e+")
+                        append(exponentText.padStart(2, '0'))
+                    }
+                }
+                exponent < 0 -> "0." + "0".repeat(-exponent - 1) + digits
+                else -> {
+                    val integerDigits = digits.padEnd(exponent + 1, '0')
+                    integerDigits.substring(0, exponent + 1) + "." +
+                        integerDigits.substring(exponent + 1).ifEmpty { "0" }
+                }
+            }
+
+        return if (value < 0) "-$formatted" else formatted
+    }
+
+    private fun skipWhitespace(
+        text: String,
+        start: Int,
+    ): Int {
+        var position = start
+        // Matches sqlite3Isspace, which doesn't consider non-ASCII whitespace.
+        while (position < text.length && text[position] in " \t\n\u000B\u000C\r") {
+            position++
+        }
+        return position
+    }
+
+    private fun skipDigits(
+        text: String,
+        start: Int,
+    ): Int {
+        var position = start
+        while (position < text.length && text[position].isAsciiDigit()) {
+            position++
+        }
+        return position
+    }
+
+    private fun Char.isAsciiDigit() = this in '0'..'9'
+
+    private const val SIGNIFICANT_DIGITS = 15
+}
@@ -0,0 +1,222 @@
+package com.powersync.db.internal
+
+import io.ktor.utils.io.InternalAPI
+import io.ktor.utils.io.locks.SynchronizedObject
+import io.ktor.utils.io.locks.synchronized
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.CoroutineStart
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.channels.ReceiveChannel
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.launch
+
+/**
+ * Fans out table updates to subscribers interested in specific tables.
+ *
+ * A single coroutine collects [updates] while there are subscribers. Table names are interned to
+ * integer ids, and each id refers to the subscribers watching that table. This way, an update only
+ * wakes subscribers watching one of the affected tables, without computing set intersections for
+ * every subscriber.
+ */
+@OptIn(InternalAPI::class)
+internal class TableUpdateDispatcher(
+    private val updates: Flow<Set<String>>,
+    private val scope: CoroutineScope,
+) : SynchronizedObject() {
+    // All fields below are guarded by synchronizing on this dispatcher.
+    private val tableIds = HashMap<String, Int>()
+    private val subscribersByTable = ArrayList<MutableList<Slot>>()
+    private val subscribers = HashSet<Subscription>()
+    private var collector: Job? = null
+
+    // Incremented whenever the collector should stop, so that a collector that is still starting
+    // can tell that it is no longer needed.
+    private var collectorGeneration = 0
+
+    /**
+     * Starts listening for updates on [tables].
+     *
+     * The returned subscription is notified for updates made after this call returns. It must be
+     * [closed][Subscription.close] when no longer needed. If collecting updates fails, its
+     * [Subscription.wakeups] channel is closed with the cause.
+     */
+    fun subscribe(tables: Collection<String>): Subscription {
+        val subscription = Subscription(tables.distinct())
+
+        val generation =
+            synchronized(this) {
+                subscription.tables.forEachIndexed { index, name ->
+                    val id = tableIds.getOrPut(name) { subscribersByTable.size.also { subscribersByTable.add(mutableListOf()) } }
+                    subscription.ids[index] = id
+                    subscribersByTable[id].add(Slot(subscription, index))
+                }
+
+                subscribers.add(subscription)
+                if (subscribers.size == 1) collectorGeneration else null
+            }
+
+        if (generation != null) {
+            startCollector(generation)
+        }
+
+        return subscription
+    }
+
+    private fun startCollector(generation: Int) {
+        // Starting undispatched ensures the collector has subscribed to the shared updates flow
+        // before subscribe() returns. This happens outside of the lock because subscribing may
+        // open the database.
+        val job =
+            scope.launch(start = CoroutineStart.UNDISPATCHED) {
+                try {
+                    updates.collect { dispatch(it) }
+                } catch (e: CancellationException) {
+                    throw e
+                } catch (e: Throwable) {
+                    fail(generation, e)
+                }
+            }
+
+        val isStale =
+            synchronized(this) {
+                if (generation == collectorGeneration) {
+                    collector = job
+                    false
+                } else {
+                    true
+                }
+            }
+
+        if (isStale) {
+            job.cancel()
+        }
+    }
+
+    private fun dispatch(changedTables: Set<String>) {
+        synchronized(this) {
+            for (name in changedTables) {
+                val id = tableIds[name] ?: continue
+                for (slot in subscribersByTable[id]) {
+                    slot.subscription.markChanged(slot.index)
+                }
+            }
+        }
+    }
+
+    /**
+     * Closes all current subscriptions with [cause], since they won't receive further updates.
+     *
+     * Later subscriptions start a new collector.
+     */
+    private fun fail(
+        generation: Int,
+        cause: Throwable,
+    ) {
+        val failed =
+            synchronized(this) {
+                if (generation != collectorGeneration) return
+
+                collectorGeneration++
+                collector = null
+                subscribersByTable.forEach { it.clear() }
+                subscribers.toList().also {
+                    subscribers.clear()
+                    it.forEach { subscription -> subscription.markClosed() }
+                }
+            }
+
+        failed.forEach { it.closeWakeups(cause) }
+    }
+
+    private fun unsubscribe(subscription: Subscription) {
+        val toCancel =
+            synchronized(this) {
+                for (id in subscription.ids) {
+                    subscribersByTable[id].removeAll { it.subscription === subscription }
+                }
+
+                if (subscribers.remove(subscription) && subscribers.isEmpty()) {
+                    collectorGeneration++
+                    collector.also { collector = null }
+                } else {
+                    null
+                }
+            }
+
+        toCancel?.cancel()
+    }
+
+    private class Slot(
+        val subscription: Subscription,
+        val index: Int,
+    )
+
+    inner class Subscription(
+        val tables: List<String>,
+    ) {
+        val ids = IntArray(tables.size)
+
+        // Guarded by the dispatcher.
+        private val changed = BooleanArray(tables.size)
+        private var closed = false
+        private val signals = Channel<Unit>(Channel.CONFLATED)
+
+        /**
+         * A channel receiving an element after one of the subscribed tables has been updated.
+         * Multiple updates before the element is received are conflated.
+         */
+        val wakeups: ReceiveChannel<Unit>
+            get() = signals
+
+        fun markChanged(index: Int) {
+            changed[index] = true
+            signals.trySend(Unit)
+        }
+
+        /**
+         * Wakes up the subscriber without marking any tables as changed.
+         */
+        fun wakeUp() {
+            signals.trySend(Unit)
+        }
+
+        /**
+         * Returns the subscribed tables that have been changed since the last call, and resets
+         * them.
+         */
+        fun takeChangedTables(): Set<String> =
+            synchronized(this@TableUpdateDispatcher) {
+                buildSet {
+                    for (i in changed.indices) {
+                        if (changed[i]) {
+                            add(tables[i])
+                            changed[i] = false
+                        }
+                    }
+                }
+            }
+
+        // Must be called while synchronizing on the dispatcher.
+        fun markClosed() {
+            closed = true
+        }
+
+        fun closeWakeups(cause: Throwable) {
+            signals.close(cause)
+        }
+
+        fun close() {
+            val wasClosed =
+                synchronized(this@TableUpdateDispatcher) {
+                    closed.also { closed = true }
+                }
+
+            if (!wasClosed) {
+                signals.close()
+                unsubscribe(this)
+            }
+        }
+    }
+}
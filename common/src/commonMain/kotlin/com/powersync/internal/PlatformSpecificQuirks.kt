@@ -31,4 +31,19 @@ internal val HttpClientEngineConfig.shouldUseRSocketStream: Boolean
         return check(this)
     }
 
+/**
+ * A hook installed by the `:core` project.
+ *
+ * The hook is responsible for determining whether a given [HttpClientEngine] negotiates and
+ * decompresses compressed responses by itself, which is the case for the `Darwin` HTTP engine.
+ * Such engines must not decompress responses a second time.
+ */
+@OptIn(ExperimentalAtomicApi::class)
+@InternalPowerSyncAPI
+public val httpClientIsKnownToDecompressResponses: AtomicReference<((HttpClientEngineConfig) -> Boolean)?> = AtomicReference(null)
+
+@OptIn(ExperimentalAtomicApi::class, InternalPowerSyncAPI::class)
+internal val HttpClientEngineConfig.decompressesResponses: Boolean
+    get() = httpClientIsKnownToDecompressResponses.load()?.invoke(this) ?: false
+
 internal expect fun platformAllowsWebSockets(): Boolean
@@ -1,6 +1,7 @@
 package com.powersync.sync
 
 import com.powersync.ExperimentalPowerSyncAPI
+import com.powersync.internal.decompressesResponses
 import com.powersync.internal.shouldUseRSocketStream
 import com.powersync.sync.StreamingSyncClient.Companion.SOCKET_TIMEOUT
 import io.ktor.client.HttpClient
@@ -8,6 +9,9 @@ import io.ktor.client.HttpClientConfig
 import io.ktor.client.plugins.DefaultRequest
 import io.ktor.client.plugins.HttpClientPlugin
 import io.ktor.client.plugins.HttpTimeout
+import io.ktor.client.plugins.api.ClientPluginInstance
+import io.ktor.client.plugins.compression.ContentEncoding
+import io.ktor.client.plugins.compression.ContentEncodingConfig
 import io.ktor.client.plugins.contentnegotiation.ContentNegotiation
 import io.ktor.client.plugins.websocket.WebSockets
 import io.ktor.util.AttributeKey
@@ -21,6 +25,12 @@ import io.ktor.util.AttributeKey
  * This is currently only necessary when using a [SyncClientConfiguration.ExistingClient] for PowerSync
  * network requests.
  *
+ * When [compressResponses] is enabled, the client advertises support for `gzip` and `deflate`
+ * content encodings and decompresses responses incrementally as they're read. This reduces the
+ * amount of data transferred for large syncs at the cost of some CPU time. Other encodings,
+ * including `zstd`, are not supported. The Darwin engine negotiates compression by itself, so
+ * this option has no effect there.
+ *
  * Example usage:
  *
  * ```kotlin
@@ -31,13 +41,24 @@ import io.ktor.util.AttributeKey
  * ```
  */
 @ExperimentalPowerSyncAPI
-public fun HttpClientConfig<*>.configureSyncHttpClient(userAgent: String = userAgent()) {
+public fun HttpClientConfig<*>.configureSyncHttpClient(
+    userAgent: String = userAgent(),
+    compressResponses: Boolean = false,
+) {
     install(HttpTimeout) {
         socketTimeoutMillis = SOCKET_TIMEOUT
     }
     install(ContentNegotiation)
     install(WebSocketIfNecessaryPlugin)
 
+    if (compressResponses) {
+        install(ContentEncodingIfNecessaryPlugin) {
+            mode = ContentEncodingConfig.Mode.DecompressResponse
+            gzip()
+            deflate()
+        }
+    }
+
     install(DefaultRequest) {
         headers {
             append("User-Agent", userAgent)
@@ -74,3 +95,25 @@ internal object WebSocketIfNecessaryPlugin : HttpClientPlugin<Unit, WebSockets>
         }
     }
 }
+
+/**
+ * A client plugin that installs [ContentEncoding] unless the HTTP client implementation is known to
+ * decompress responses by itself, in which case responses would be decompressed twice.
+ */
+internal object ContentEncodingIfNecessaryPlugin :
+    HttpClientPlugin<ContentEncodingConfig, ClientPluginInstance<ContentEncodingConfig>> {
+    override val key: AttributeKey<ClientPluginInstance<ContentEncodingConfig>>
+        get() = ContentEncoding.key
+
+    override fun prepare(block: ContentEncodingConfig.() -> Unit): ClientPluginInstance<ContentEncodingConfig> =
+        ContentEncoding.prepare(block)
+
+    override fun install(
+        plugin: ClientPluginInstance<ContentEncodingConfig>,
+        scope: HttpClient,
+    ) {
+        if (!scope.engineConfig.decompressesResponses) {
+            ContentEncoding.install(plugin, scope)
+        }
+    }
+}
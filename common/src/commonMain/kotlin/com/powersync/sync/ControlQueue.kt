@@ -0,0 +1,91 @@
+package com.powersync.sync
+
+import com.powersync.ExperimentalPowerSyncAPI
+import com.powersync.bucket.PowerSyncControlArguments
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.first
+import kotlinx.coroutines.flow.updateAndGet
+
+/**
+ * The queue of [PowerSyncControlArguments] processed by a sync iteration.
+ *
+ * Sync lines count towards a budget of [capacityBytes]: Once the budget is exhausted, [send]
+ * suspends until enough lines have been received. This lets the network reader run ahead of the
+ * database while keeping backpressure towards the service. Other arguments don't count towards the
+ * budget and are never delayed by it.
+ *
+ * Only a single coroutine may send sync lines.
+ */
+@OptIn(ExperimentalPowerSyncAPI::class)
+internal class ControlQueue(
+    private val capacityBytes: Long,
+    private val metrics: SyncMetrics? = null,
+) {
+    private val channel = Channel<PowerSyncControlArguments>(Channel.UNLIMITED)
+    private val state = MutableStateFlow(PrefetchBufferState(capacityBytes = capacityBytes))
+
+    val bufferState: StateFlow<PrefetchBufferState>
+        get() = state
+
+    init {
+        metrics?.prefetchBufferState?.value = state.value
+    }
+
+    suspend fun send(args: PowerSyncControlArguments) {
+        val size = args.syncLineSize?.toLong()
+        if (size != null) {
+            if (!state.value.hasRoomFor(size)) {
+                publish { it.copy(backpressureStalls = it.backpressureStalls + 1) }
+                // There's only one sender of sync lines, so the room can't be taken by someone else
+                // between waiting for it and reserving it.
+                state.first { it.hasRoomFor(size) }
+            }
+
+            publish {
+                val bytes = it.bufferedBytes + size
+                it.copy(
+                    bufferedLines = it.bufferedLines + 1,
+                    bufferedBytes = bytes,
+                    peakBufferedBytes = maxOf(it.peakBufferedBytes, bytes),
+                )
+            }
+        }
+
+        channel.send(args)
+    }
+
+    /**
+     * Waits for the next argument, returning `null` once the queue has been closed.
+     */
+    suspend fun receiveOrNull(): PowerSyncControlArguments? = channel.receiveCatching().getOrNull()?.also(::release)
+
+    /**
+     * Returns the next argument if one is available without suspending.
+     */
+    fun tryReceive(): PowerSyncControlArguments? = channel.tryReceive().getOrNull()?.also(::release)
+
+    fun close() {
+        channel.close()
+    }
+
+    private fun release(args: PowerSyncControlArguments) {
+        val size = args.syncLineSize ?: return
+        publish {
+            it.copy(
+                bufferedLines = it.bufferedLines - 1,
+                bufferedBytes = it.bufferedBytes - size,
+            )
+        }
+    }
+
+    private inline fun publish(update: (PrefetchBufferState) -> PrefetchBufferState) {
+        val updated = state.updateAndGet(update)
+        metrics?.prefetchBufferState?.value = updated
+    }
+
+    // A line is always admitted into an empty buffer, otherwise lines larger than the budget would
+    // never be received.
+    private fun PrefetchBufferState.hasRoomFor(size: Long): Boolean = bufferedBytes == 0L || bufferedBytes + size <= capacityBytes
+}
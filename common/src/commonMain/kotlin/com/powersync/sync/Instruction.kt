@@ -2,6 +2,7 @@ package com.powersync.sync
 
 import com.powersync.bucket.StreamPriority
 import com.powersync.db.crud.TypedRow
+import com.powersync.utils.JsonUtil
 import kotlinx.serialization.KSerializer
 import kotlinx.serialization.SerialName
 import kotlinx.serialization.Serializable
@@ -29,10 +30,38 @@ internal sealed interface Instruction {
         val line: String,
     ) : Instruction
 
-    @Serializable
-    data class UpdateSyncStatus(
-        val status: CoreSyncStatus,
-    ) : Instruction
+    class UpdateSyncStatus private constructor(
+        decodeStatus: () -> CoreSyncStatus,
+    ) : Instruction {
+        constructor(status: CoreSyncStatus) : this({ status })
+
+        /**
+         * The new status, decoded on first access.
+         *
+         * Status updates are frequent and large, but superseded by later updates (see
+         * [coalesceStatusUpdates]). Instructions returned by [decodeInstructions] only decode the
+         * status once it's actually used.
+         */
+        val status: CoreSyncStatus by lazy(decodeStatus)
+
+        override fun equals(other: Any?): Boolean = other is UpdateSyncStatus && other.status == status
+
+        override fun hashCode(): Int = status.hashCode()
+
+        override fun toString(): String = "UpdateSyncStatus(status=$status)"
+
+        @Serializable
+        class Payload(
+            val status: CoreSyncStatus,
+        )
+
+        companion object {
+            fun decodingLazily(payloadJson: String): UpdateSyncStatus =
+                UpdateSyncStatus {
+                    JsonUtil.json.decodeFromString(Payload.serializer(), payloadJson).status
+                }
+        }
+    }
 
     @Serializable
     data class EstablishSyncStream(
@@ -59,9 +88,16 @@ internal sealed interface Instruction {
         val raw: JsonElement?,
     ) : Instruction
 
+    /**
+     * Whether this instruction changes the state of the sync stream, meaning that lines received
+     * afterwards must not be applied in the same batch.
+     */
+    val endsControlBatch: Boolean
+        get() = this is EstablishSyncStream || this is CloseSyncStream
+
     class Serializer : KSerializer<Instruction> {
         private val logLine = serializer<LogLine>()
-        private val updateSyncStatus = serializer<UpdateSyncStatus>()
+        private val updateSyncStatus = serializer<UpdateSyncStatus.Payload>()
         private val establishSyncStream = serializer<EstablishSyncStream>()
         private val fetchCredentials = serializer<FetchCredentials>()
         private val flushFileSystem = serializer<JsonObject>()
@@ -88,7 +124,7 @@ internal sealed interface Instruction {
                         }
 
                         1 -> {
-                            decodeSerializableElement(descriptor, 1, updateSyncStatus)
+                            UpdateSyncStatus(decodeSerializableElement(descriptor, 1, updateSyncStatus).status)
                         }
 
                         2 -> {
@@ -146,6 +182,164 @@ internal sealed interface Instruction {
     }
 }
 
+/**
+ * Decodes the JSON array of instructions returned by `powersync_control`.
+ *
+ * This scans the array without building a tree of JSON elements. Payloads of
+ * [Instruction.UpdateSyncStatus] are only decoded when their status is accessed, other instructions
+ * are decoded eagerly with [Instruction.Serializer].
+ */
+internal fun decodeInstructions(json: String): List<Instruction> =
+    InstructionScanner(json).scan()
+        ?: JsonUtil.json.decodeFromString<List<Instruction>>(json)
+
+/**
+ * Splits a JSON array of single-key objects into its elements.
+ *
+ * The scanner only tracks nesting and string literals, it doesn't validate values. When the input
+ * has an unexpected structure, [scan] returns `null` and callers fall back to a full decode which
+ * reports errors properly.
+ */
+private class InstructionScanner(
+    private val json: String,
+) {
+    private var offset = 0
+
+    fun scan(): List<Instruction>? {
+        val instructions = mutableListOf<Instruction>()
+
+        skipWhitespace()
+        if (!consume('[')) return null
+        skipWhitespace()
+        if (consume(']')) return instructions
+
+        while (true) {
+            skipWhitespace()
+            instructions.add(scanInstruction() ?: return null)
+            skipWhitespace()
+
+            when {
+                consume(',') -> continue
+                consume(']') -> break
+                else -> return null
+            }
+        }
+
+        skipWhitespace()
+        return if (offset == json.length) instructions else null
+    }
+
+    private fun scanInstruction(): Instruction? {
+        val start = offset
+        if (!consume('{')) return null
+        skipWhitespace()
+
+        val keyStart = offset
+        if (!skipString()) return null
+        val key = json.substring(keyStart + 1, offset - 1)
+        skipWhitespace()
+        if (!consume(':')) return null
+        skipWhitespace()
+
+        val valueStart = offset
+        if (!skipValue()) return null
+        val valueEnd = offset
+        skipWhitespace()
+        if (!consume('}')) {
+            // Not a single-key object, let the serializer turn this into an unknown instruction.
+            return null
+        }
+
+        return if (key == "UpdateSyncStatus") {
+            Instruction.UpdateSyncStatus.decodingLazily(json.substring(valueStart, valueEnd))
+        } else {
+            JsonUtil.json.decodeFromString(serializer, json.substring(start, offset))
+        }
+    }
+
+    private fun skipValue(): Boolean {
+        val start = offset
+        var depth = 0
+        while (offset < json.length) {
+            val char = json[offset]
+            when {
+                char == '"' -> {
+                    if (!skipString()) return false
+                    if (depth == 0) return true
+                    continue
+                }
+
+                char == '{' || char == '[' -> {
+                    depth++
+                }
+
+                char == '}' || char == ']' -> {
+                    // At depth 0, this ends a primitive value.
+                    if (depth == 0) return offset > start
+                    depth--
+                    if (depth == 0) {
+                        offset++
+                        return true
+                    }
+                }
+
+                depth == 0 && (char == ',' || char.isWhitespace()) -> {
+                    return offset > start
+                }
+            }
+            offset++
+        }
+
+        return depth == 0 && offset > start
+    }
+
+    private fun skipString(): Boolean {
+        if (!consume('"')) return false
+        while (offset < json.length) {
+            when (json[offset++]) {
+                '\\' -> offset++
+                '"' -> return true
+            }
+        }
+        return false
+    }
+
+    private fun skipWhitespace() {
+        while (offset < json.length && json[offset].isWhitespace()) {
+            offset++
+        }
+    }
+
+    private fun consume(char: Char): Boolean {
+        if (offset < json.length && json[offset] == char) {
+            offset++
+            return true
+        }
+        return false
+    }
+
+    private companion object {
+        val serializer = Instruction.Serializer()
+    }
+}
+
+/**
+ * Removes [Instruction.UpdateSyncStatus] instructions followed by another status update.
+ *
+ * Each status update describes the complete state of the core extension, so only the last one in
+ * a batch of instructions needs to be applied.
+ */
+internal fun List<Instruction>.coalesceStatusUpdates(): List<Instruction> {
+    val lastStatusUpdate = indexOfLast { it is Instruction.UpdateSyncStatus }
+    if (lastStatusUpdate == -1) {
+        return this
+    }
+
+    return filterIndexed { index, instruction ->
+        instruction !is Instruction.UpdateSyncStatus || index == lastStatusUpdate
+    }
+}
+
 @Serializable
 internal data class CoreSyncStatus(
     val connected: Boolean,
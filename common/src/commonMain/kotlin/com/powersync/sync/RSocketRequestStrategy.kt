@@ -0,0 +1,106 @@
+package com.powersync.sync
+
+import com.powersync.ExperimentalPowerSyncAPI
+import io.rsocket.kotlin.ExperimentalStreamsApi
+import io.rsocket.kotlin.RequestStrategy
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.first
+import kotlinx.coroutines.flow.update
+import kotlin.time.Duration
+
+/**
+ * Requests sync lines over RSocket based on how quickly they're applied to the database and how
+ * much of the prefetch [buffer] is in use.
+ *
+ * The amount of requested lines (the `REQUEST_N` credit) that haven't been received yet is kept
+ * close to a window: enough lines to keep the database busy for
+ * [RSocketFlowControl.targetBacklog], limited by the room left in the prefetch buffer. Once half of
+ * the window has been received, it's topped up again. If no lines are outstanding and the buffer is
+ * full, requesting more lines waits until the buffer has room again.
+ */
+@OptIn(ExperimentalStreamsApi::class, ExperimentalPowerSyncAPI::class)
+internal class AdaptiveRequestStrategy(
+    private val options: RSocketFlowControl,
+    private val buffer: StateFlow<PrefetchBufferState>,
+) : RequestStrategy {
+    // Exponentially weighted moving averages, updated by the network reader and the coroutine
+    // applying lines respectively.
+    private val averageLineBytes = MutableStateFlow(0.0)
+    private val applyNanosPerByte = MutableStateFlow(0.0)
+
+    override fun provide(): RequestStrategy.Element = Element()
+
+    fun recordReceived(bytes: Int) {
+        averageLineBytes.update { average(it, bytes.toDouble()) }
+    }
+
+    fun recordApplied(
+        bytes: Long,
+        duration: Duration,
+    ) {
+        if (bytes <= 0) return
+        applyNanosPerByte.update { average(it, duration.inWholeNanoseconds.toDouble() / bytes) }
+    }
+
+    /**
+     * The amount of lines that should be outstanding.
+     */
+    fun window(): Int {
+        val lineBytes = averageLineBytes.value
+        if (lineBytes <= 0) {
+            return options.initialRequest
+        }
+
+        val nanosPerLine = applyNanosPerByte.value * lineBytes
+        val byLatency =
+            if (nanosPerLine <= 0) {
+                options.maxRequest.toDouble()
+            } else {
+                options.targetBacklog.inWholeNanoseconds / nanosPerLine
+            }
+
+        val state = buffer.value
+        val byBytes = (state.capacityBytes - state.bufferedBytes).coerceAtLeast(0) / lineBytes
+
+        return minOf(byLatency, byBytes).toInt().coerceIn(1, options.maxRequest)
+    }
+
+    private inner class Element : RequestStrategy.Element {
+        private var outstanding = 0
+
+        override suspend fun firstRequest(): Int {
+            outstanding = options.initialRequest
+            return outstanding
+        }
+
+        override suspend fun nextRequest(): Int {
+            outstanding--
+            if (outstanding > window() / 2) {
+                return 0
+            }
+
+            if (outstanding == 0) {
+                // Nothing is in flight, so the stream would stall if we didn't request anything.
+                // Wait for the buffer to have room for more lines instead.
+                buffer.first { it.bufferedBytes < it.capacityBytes }
+            }
+
+            val request = window() - outstanding
+            if (request <= 0) {
+                return 0
+            }
+            outstanding += request
+            return request
+        }
+    }
+
+    private companion object {
+        const val SMOOTHING = 0.2
+
+        fun average(
+            current: Double,
+            sample: Double,
+        ): Double = if (current == 0.0) sample else current + SMOOTHING * (sample - current)
+    }
+}
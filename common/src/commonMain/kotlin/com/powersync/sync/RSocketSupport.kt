@@ -50,6 +50,7 @@ internal fun HttpClient.rSocketSyncStream(
     userAgent: String,
     req: JsonElement,
     credentials: PowerSyncCredentials,
+    requestStrategy: AdaptiveRequestStrategy,
 ): Flow<PowerSyncControlArguments> =
     flow {
         try {
@@ -133,8 +134,12 @@ internal fun HttpClient.rSocketSyncStream(
                             connectionEstablishedEmitted = true
                             emit(PowerSyncControlArguments.ConnectionEstablished)
                         }
-                        emit(PowerSyncControlArguments.BinaryLine(payload.data.readByteArray()))
-                    }.flowOn(Dispatchers.IO),
+                        val line = payload.data.readByteArray()
+                        requestStrategy.recordReceived(line.size)
+                        emit(PowerSyncControlArguments.BinaryLine(line))
+                    }
+                    // The request strategy decides how many lines to request from the stream.
+                    .flowOn(Dispatchers.IO + requestStrategy),
             )
             emit(PowerSyncControlArguments.ResponseStreamEnd)
         } catch (e: CancellationException) {
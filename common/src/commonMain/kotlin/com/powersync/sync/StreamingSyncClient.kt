@@ -31,7 +31,6 @@ import io.ktor.http.contentType
 import io.ktor.utils.io.ByteReadChannel
 import io.ktor.utils.io.readAvailable
 import io.ktor.utils.io.readBuffer
-import io.ktor.utils.io.readLineStrict
 import io.rsocket.kotlin.RSocketError
 import kotlinx.coroutines.CancellationException
 import kotlinx.coroutines.CompletableDeferred
@@ -54,11 +53,15 @@ import kotlinx.coroutines.flow.flow
 import kotlinx.coroutines.flow.map
 import kotlinx.coroutines.launch
 import kotlinx.coroutines.withContext
+import kotlinx.io.Buffer
 import kotlinx.io.EOFException
+import kotlinx.io.indexOf
 import kotlinx.io.readByteArray
 import kotlinx.io.readIntLe
 import kotlinx.serialization.json.JsonElement
 import kotlinx.serialization.json.JsonObject
+import kotlin.time.Duration.Companion.milliseconds
+import kotlin.time.TimeSource
 
 @OptIn(ExperimentalPowerSyncAPI::class)
 internal class StreamingSyncClient(
@@ -88,7 +91,7 @@ internal class StreamingSyncClient(
         when (val config = options.clientConfiguration) {
             is SyncClientConfiguration.ExtendedConfig -> {
                 HttpClient {
-                    configureSyncHttpClient(options.userAgent)
+                    configureSyncHttpClient(options.userAgent, compressResponses = options.compressSyncStream)
                     config.block(this)
                 }
             }
@@ -297,11 +300,15 @@ internal class StreamingSyncClient(
 
         // We're only using a channelFlow to allow consumer and producer to be on different coroutine contexts (which is
         // a requirement because request.execute changes the context to the one of the engine). However, we still want
-        // each emit() to block until it has been received to preserve backpressure.
+        // each emit() to block until it has been received to preserve backpressure. Reading ahead of the database is
+        // bounded by the ControlQueue the lines are sent to.
         return originalFlow.buffer(Channel.RENDEZVOUS)
     }
 
-    private fun receiveTextOrBinaryLines(req: JsonElement): Flow<PowerSyncControlArguments> {
+    private fun receiveTextOrBinaryLines(
+        req: JsonElement,
+        requestStrategy: AdaptiveRequestStrategy,
+    ): Flow<PowerSyncControlArguments> {
         val needsRSocket = httpClient.attributes[WebSocketIfNecessaryPlugin.needsRSocketKey]
 
         return if (!needsRSocket) {
@@ -313,7 +320,7 @@ internal class StreamingSyncClient(
                 if (isBson) {
                     emitAll(body.bsonObjects().map { PowerSyncControlArguments.BinaryLine(it) })
                 } else {
-                    emitAll(body.lines().map { PowerSyncControlArguments.TextLine(it) })
+                    emitAll(body.lineBytes().map { PowerSyncControlArguments.Utf8TextLine(it) })
                 }
 
                 emit(PowerSyncControlArguments.ResponseStreamEnd)
@@ -329,6 +336,7 @@ internal class StreamingSyncClient(
                         userAgent = options.userAgent,
                         credentials = credentials,
                         req = req,
+                        requestStrategy = requestStrategy,
                     ),
                 )
             }
@@ -363,10 +371,17 @@ internal class StreamingSyncClient(
         var fetchLinesJob: Job? = null
         var credentialsInvalidation: Job? = null
 
-        // Using a channel for control invocations so that they're handled by a single coroutine,
-        // avoiding races between concurrent jobs like fetching credentials.
-        private val controlInvocations = Channel<PowerSyncControlArguments>()
+        // Using a queue for control invocations so that they're handled by a single coroutine,
+        // avoiding races between concurrent jobs like fetching credentials. Sync lines received
+        // while the previous batch is being applied are prefetched up to the configured budget and
+        // batched together.
+        private val controlInvocations = ControlQueue(options.prefetchBufferBytes, options.metrics)
+
+        // Only used for RSocket streams, which need to request lines explicitly.
+        private val requestStrategy =
+            AdaptiveRequestStrategy(options.rSocketFlowControl, controlInvocations.bufferState)
         private var result = SyncIterationResult()
+        private var streamClosed = false
 
         private suspend fun invokeControl(args: PowerSyncControlArguments) {
             val instructions = bucketStorage.control(args)
@@ -399,11 +414,40 @@ internal class StreamingSyncClient(
                 }
 
             var hadSyncLine = false
-            for (line in controlInvocations) {
-                val instructions = bucketStorage.control(line)
-                instructions.forEach { handleInstruction(it) }
+            var pending: PowerSyncControlArguments? = null
+            while (true) {
+                val line = pending ?: controlInvocations.receiveOrNull() ?: break
+                pending = null
+
+                if (line.syncLineSize == null) {
+                    invokeControl(line)
+                    continue
+                }
+
+                if (streamClosed) {
+                    // Lines buffered before the stream was closed must not be applied.
+                    continue
+                }
+
+                // Drain sync lines that are already queued to apply them in a single transaction,
+                // saving a commit and update notifications per line.
+                val batch = mutableListOf(line)
+                var batchBytes = line.syncLineSize!!
+                while (batch.size < MAX_LINES_PER_BATCH && batchBytes < MAX_BYTES_PER_BATCH) {
+                    val next = controlInvocations.tryReceive() ?: break
+                    val size = next.syncLineSize
+                    if (size == null) {
+                        pending = next
+                        break
+                    }
 
-                if (!hadSyncLine && (line is PowerSyncControlArguments.TextLine || line is PowerSyncControlArguments.BinaryLine)) {
+                    batch.add(next)
+                    batchBytes += size
+                }
+
+                applySyncLines(batch)
+
+                if (!hadSyncLine) {
                     // Trigger a crud upload when receiving the first sync line: We could have
                     // pending local writes made while disconnected, so in addition to listening on
                     // updates to `ps_crud`, we also need to trigger a CRUD upload in some other
@@ -418,6 +462,18 @@ internal class StreamingSyncClient(
             return result
         }
 
+        private suspend fun applySyncLines(lines: List<PowerSyncControlArguments>) {
+            val started = TimeSource.Monotonic.markNow()
+            var remaining = lines
+            while (remaining.isNotEmpty() && !streamClosed) {
+                val batch = bucketStorage.controlBatch(remaining, MAX_BATCH_DURATION)
+                batch.instructions.forEach { handleInstruction(it) }
+                remaining = remaining.subList(batch.processed, remaining.size)
+            }
+
+            requestStrategy.recordApplied(lines.sumOf { it.syncLineSize!!.toLong() }, started.elapsedNow())
+        }
+
         suspend fun stop() {
             invokeControl(PowerSyncControlArguments.Stop)
             fetchLinesJob?.join()
@@ -451,6 +507,7 @@ internal class StreamingSyncClient(
                     val hideDisconnect = instruction.hideDisconnect
                     logger.v { "Closing sync stream connection. Hide disconnect: $hideDisconnect" }
                     result = SyncIterationResult(hideDisconnect)
+                    streamClosed = true
                     fetchLinesJob!!.cancelAndJoin()
                     fetchLinesJob = null
                     logger.v { "Sync stream connection shut down" }
@@ -513,7 +570,7 @@ internal class StreamingSyncClient(
         }
 
         private suspend fun connect(start: Instruction.EstablishSyncStream) {
-            receiveTextOrBinaryLines(start.request).collect {
+            receiveTextOrBinaryLines(start.request, requestStrategy).collect {
                 controlInvocations.send(it)
             }
         }
@@ -524,6 +581,15 @@ internal class StreamingSyncClient(
         // in twice that time, assume the connection is broken.
         internal const val SOCKET_TIMEOUT: Long = 40_000
 
+        // Limits for sync lines applied in a single powersync_control transaction. Batches only
+        // consist of lines that have already been received, so they don't add latency.
+        private const val MAX_LINES_PER_BATCH = 64
+        private const val MAX_BYTES_PER_BATCH = 1024 * 1024
+        private val MAX_BATCH_DURATION = 100.milliseconds
+
+        private const val NEWLINE: Byte = 0x0A
+        private const val CARRIAGE_RETURN: Byte = 0x0D
+
         private val ndjson = ContentType("application", "x-ndjson")
         private val bsonStream = ContentType("application", "vnd.powersync.bson-stream")
 
@@ -532,16 +598,49 @@ internal class StreamingSyncClient(
                 config(this)
             }
 
-        fun ByteReadChannel.lines(): Flow<String> =
+        /**
+         * Splits the channel into newline-delimited lines, emitting the raw bytes of each line.
+         *
+         * Lines are found by scanning buffered bytes for `\n` directly, so no [String] is created
+         * for them. A trailing `\r` is removed and empty lines are skipped.
+         */
+        fun ByteReadChannel.lineBytes(): Flow<ByteArray> =
             flow {
-                while (!isClosedForRead) {
-                    val line = readLineStrict()
-                    if (line != null) {
-                        emit(line)
+                val buffer = Buffer()
+                // The amount of bytes at the start of the buffer known not to contain a newline.
+                var scanned = 0L
+
+                while (true) {
+                    val newline = buffer.indexOf(NEWLINE, startIndex = scanned)
+                    if (newline != -1L) {
+                        val line = buffer.readByteArray(newline.toInt())
+                        buffer.skip(1)
+                        scanned = 0
+                        emitLine(line)
+                        continue
+                    }
+
+                    scanned = buffer.size
+                    val bytesRead =
+                        readAvailable(1) { source ->
+                            source.readAtMostTo(buffer, source.size).toInt()
+                        }
+                    if (bytesRead == -1 && (isClosedForRead || !awaitContent(1))) {
+                        break
                     }
                 }
+
+                // The last line doesn't need to be terminated.
+                emitLine(buffer.readByteArray())
             }
 
+        private suspend fun FlowCollector<ByteArray>.emitLine(line: ByteArray) {
+            val length = if (line.isNotEmpty() && line.last() == CARRIAGE_RETURN) line.size - 1 else line.size
+            if (length > 0) {
+                emit(if (length == line.size) line else line.copyOf(length))
+            }
+        }
+
         fun ByteReadChannel.bsonObjects(): Flow<ByteArray> =
             flow {
                 while (true) {
@@ -0,0 +1,53 @@
+package com.powersync.sync
+
+import com.powersync.ExperimentalPowerSyncAPI
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.asStateFlow
+
+/**
+ * Metrics describing the sync pipeline between the PowerSync service and the local database.
+ *
+ * Pass an instance to [SyncOptions.metrics] and collect its flows to observe it. Values are
+ * updated while the database is connected, and reset each time a new sync stream is opened.
+ */
+@ExperimentalPowerSyncAPI
+public class SyncMetrics {
+    internal val prefetchBufferState = MutableStateFlow(PrefetchBufferState())
+
+    /**
+     * The state of the buffer holding sync lines that have been received from the service but not
+     * yet applied to the database.
+     */
+    public val prefetchBuffer: StateFlow<PrefetchBufferState> = prefetchBufferState.asStateFlow()
+}
+
+/**
+ * A snapshot of the prefetch buffer configured with [SyncOptions.prefetchBufferBytes].
+ */
+@ExperimentalPowerSyncAPI
+public data class PrefetchBufferState(
+    /**
+     * The amount of sync lines waiting to be applied.
+     */
+    val bufferedLines: Int = 0,
+    /**
+     * The total size of sync lines waiting to be applied, in bytes.
+     */
+    val bufferedBytes: Long = 0,
+    /**
+     * The configured budget of the buffer, in bytes.
+     */
+    val capacityBytes: Long = 0,
+    /**
+     * The largest value of [bufferedBytes] observed for the current sync stream.
+     */
+    val peakBufferedBytes: Long = 0,
+    /**
+     * How often reading from the network had to pause because the buffer was full.
+     *
+     * A steadily increasing value indicates that applying sync lines to the database is the
+     * bottleneck of the sync process.
+     */
+    val backpressureStalls: Long = 0,
+)
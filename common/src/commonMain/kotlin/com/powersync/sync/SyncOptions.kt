@@ -1,9 +1,12 @@
 package com.powersync.sync
 
+import com.powersync.ExperimentalPowerSyncAPI
 import com.powersync.PowerSyncDatabase
 import io.ktor.client.HttpClient
 import io.ktor.client.HttpClientConfig
 import kotlin.native.HiddenFromObjC
+import kotlin.time.Duration
+import kotlin.time.Duration.Companion.milliseconds
 
 /**
  * Configuration options for the [PowerSyncDatabase.connect] method, allowing customization of
@@ -32,6 +35,7 @@ public sealed class SyncClientConfiguration {
 /**
  * Options for [PowerSyncDatabase.connect] to customize the connection mechanism.
  */
+@OptIn(ExperimentalPowerSyncAPI::class)
 public class SyncOptions(
     /**
      * Enables the new client implementation written in Rust.
@@ -53,8 +57,57 @@ public class SyncOptions(
      * when they don't have an explicit subscription.
      */
     public val includeDefaultStreams: Boolean = true,
+    /**
+     * The amount of bytes of sync lines that may be received from the service before they have
+     * been applied to the local database.
+     *
+     * Downloading continues in the background while received lines are being written, until this
+     * budget is exhausted. Larger values can speed up the initial sync on fast networks at the cost
+     * of memory. A single line is always buffered, even if it is larger than this budget.
+     */
+    public val prefetchBufferBytes: Long = DEFAULT_PREFETCH_BUFFER_BYTES,
+    /**
+     * Whether to request compressed responses from the PowerSync service.
+     *
+     * Compressed sync streams are decoded incrementally, which can significantly reduce the amount
+     * of data transferred during the initial sync over slow networks. This has no effect when
+     * [clientConfiguration] is a [SyncClientConfiguration.ExistingClient], pass `compressResponses`
+     * to [configureSyncHttpClient] instead.
+     */
+    public val compressSyncStream: Boolean = false,
+    /**
+     * An optional [SyncMetrics] instance to update with information about the sync process.
+     */
+    @ExperimentalPowerSyncAPI
+    public val metrics: SyncMetrics? = null,
+    /**
+     * Controls how many sync lines are requested at a time when syncing over RSocket, which is
+     * used on platforms where streamed HTTP responses don't support backpressure.
+     */
+    @ExperimentalPowerSyncAPI
+    public val rSocketFlowControl: RSocketFlowControl = RSocketFlowControl(),
+    /**
+     * The minimum interval between [PowerSyncDatabase.currentStatus] updates that only change
+     * download progress.
+     *
+     * During the initial sync, progress can change hundreds of times per second. Such updates are
+     * coalesced so that collectors only see the latest progress once per interval. Other changes,
+     * like connectivity or errors, are emitted immediately. Use [Duration.ZERO] to emit every
+     * update.
+     */
+    public val statusUpdateInterval: Duration = DEFAULT_STATUS_UPDATE_INTERVAL,
 ) {
     public companion object {
+        /**
+         * The default value for [prefetchBufferBytes].
+         */
+        public const val DEFAULT_PREFETCH_BUFFER_BYTES: Long = 4L * 1024 * 1024
+
+        /**
+         * The default value for [statusUpdateInterval].
+         */
+        public val DEFAULT_STATUS_UPDATE_INTERVAL: Duration = 100.milliseconds
+
         /**
          * The default sync options, which are safe and stable to use.
          */
@@ -66,5 +119,42 @@ public class SyncOptions(
         check(newClientImplementation) {
             "Support for newClientImplementation = false has been removed"
         }
+        require(prefetchBufferBytes > 0) {
+            "prefetchBufferBytes must be positive"
+        }
+        require(!statusUpdateInterval.isNegative()) {
+            "statusUpdateInterval must not be negative"
+        }
+    }
+}
+
+/**
+ * Flow control for sync streams received over RSocket.
+ *
+ * RSocket streams only deliver as many sync lines as the client has requested. The amount of
+ * requested lines is adapted to how quickly lines are applied to the database: enough lines are
+ * requested to keep the database busy for [targetBacklog], but never more than fit into the
+ * buffer configured with [SyncOptions.prefetchBufferBytes].
+ */
+@ExperimentalPowerSyncAPI
+public class RSocketFlowControl(
+    /**
+     * The amount of lines requested when opening a stream, before any lines have been measured.
+     */
+    public val initialRequest: Int = 32,
+    /**
+     * The maximum amount of lines requested but not yet received.
+     */
+    public val maxRequest: Int = 1024,
+    /**
+     * How long applying the requested lines should take, which should be enough to cover the
+     * round trip to the service.
+     */
+    public val targetBacklog: Duration = 500.milliseconds,
+) {
+    init {
+        require(initialRequest >= 1) { "initialRequest must be at least 1" }
+        require(maxRequest >= initialRequest) { "maxRequest must not be smaller than initialRequest" }
+        require(targetBacklog.isPositive()) { "targetBacklog must be positive" }
     }
 }
@@ -2,11 +2,20 @@ package com.powersync.sync
 
 import com.powersync.bucket.StreamPriority
 import com.powersync.connectors.PowerSyncBackendConnector
+import kotlinx.coroutines.ExperimentalCoroutinesApi
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.flow.Flow
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.SharedFlow
 import kotlinx.coroutines.flow.asSharedFlow
+import kotlinx.coroutines.flow.emitAll
+import kotlinx.coroutines.flow.flow
+import kotlinx.coroutines.flow.transformLatest
 import kotlin.time.Clock
+import kotlin.time.Duration
 import kotlin.time.Instant
+import kotlin.time.TimeMark
+import kotlin.time.TimeSource
 
 @ConsistentCopyVisibility
 public data class PriorityStatusEntry internal constructor(
@@ -182,6 +191,67 @@ internal data class SyncStatusDataContainer(
             internalSubscriptions = status.streams,
         )
     }
+
+    /**
+     * Whether this status only differs from [previous] in the download progress reported while
+     * downloading.
+     */
+    internal fun differsOnlyInProgressFrom(previous: SyncStatusDataContainer): Boolean {
+        if (downloadProgress == null || previous.downloadProgress == null) {
+            return false
+        }
+
+        val subscriptions = internalSubscriptions
+        val previousSubscriptions = previous.internalSubscriptions
+        val sameSubscriptions =
+            if (subscriptions == null || previousSubscriptions == null) {
+                subscriptions == previousSubscriptions
+            } else {
+                subscriptions.size == previousSubscriptions.size &&
+                    subscriptions.indices.all {
+                        subscriptions[it].copy(progress = previousSubscriptions[it].progress) == previousSubscriptions[it]
+                    }
+            }
+
+        return sameSubscriptions &&
+            copy(downloadProgress = previous.downloadProgress, internalSubscriptions = previousSubscriptions) == previous
+    }
+}
+
+/**
+ * Emits status changes that only update download progress at most once per [interval], always
+ * emitting the latest status. Other changes (like connectivity or errors) are emitted immediately.
+ */
+@OptIn(ExperimentalCoroutinesApi::class)
+internal fun Flow<SyncStatusDataContainer>.coalesceProgressUpdates(
+    interval: Duration,
+    timeSource: TimeSource = TimeSource.Monotonic,
+): Flow<SyncStatusDataContainer> {
+    if (!interval.isPositive()) {
+        return this
+    }
+
+    return flow {
+        var lastEmitted: SyncStatusDataContainer? = null
+        var lastEmittedAt: TimeMark? = null
+
+        // A newer status cancels the pending emission of a delayed one.
+        emitAll(
+            transformLatest { status ->
+                val previous = lastEmitted
+                if (previous != null && status.differsOnlyInProgressFrom(previous)) {
+                    val remaining = interval - lastEmittedAt!!.elapsedNow()
+                    if (remaining.isPositive()) {
+                        delay(remaining)
+                    }
+                }
+
+                emit(status)
+                lastEmitted = status
+                lastEmittedAt = timeSource.markNow()
+            },
+        )
+    }
 }
 
 @ConsistentCopyVisibility
@@ -203,8 +273,14 @@ public data class SyncStatus internal constructor(
         stateFlow.value = data
     }
 
-    internal suspend fun trackOther(source: SyncStatus) {
-        source.stateFlow.collect {
+    /**
+     * Mirrors [source], emitting progress-only changes at most once per [progressInterval].
+     */
+    internal suspend fun trackOther(
+        source: SyncStatus,
+        progressInterval: Duration = Duration.ZERO,
+    ) {
+        source.stateFlow.coalesceProgressUpdates(progressInterval).collect {
             update { it }
         }
     }
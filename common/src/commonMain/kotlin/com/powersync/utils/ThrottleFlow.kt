@@ -1,6 +1,7 @@
 package com.powersync.utils
 
 import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.channels.ReceiveChannel
 import kotlinx.coroutines.delay
 import kotlinx.coroutines.flow.Flow
 import kotlinx.coroutines.flow.buffer
@@ -39,3 +40,23 @@ internal fun <T> Flow<T>.throttle(window: Duration): Flow<T> =
             // The next collect will emit the trailing edge
         }
     }
+
+/**
+ * Throttles notifications received on a conflated channel, pausing on the shared [timers].
+ *
+ * This behaves like [throttle], except that the channel already keeps only the latest event, and
+ * that pauses are scheduled on the [TimerWheel] instead of a timer per flow. Pauses of flows with
+ * the same [window] end in the same tick if they started within the same tick, so that downstream
+ * work triggered by their trailing edge runs together.
+ */
+internal fun <T> ReceiveChannel<T>.throttle(
+    window: Duration,
+    timers: TimerWheel,
+): Flow<T> =
+    flow {
+        for (value in this@throttle) {
+            val pauseUntil = TimeSource.Monotonic.markNow() + window
+            emit(value)
+            timers.delay(-pauseUntil.elapsedNow())
+        }
+    }
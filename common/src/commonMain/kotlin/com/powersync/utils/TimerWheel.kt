@@ -0,0 +1,140 @@
+package com.powersync.utils
+
+import io.ktor.utils.io.InternalAPI
+import io.ktor.utils.io.locks.SynchronizedObject
+import io.ktor.utils.io.locks.synchronized
+import kotlinx.coroutines.CancellableContinuation
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.suspendCancellableCoroutine
+import kotlin.coroutines.resume
+import kotlin.time.Duration
+import kotlin.time.Duration.Companion.milliseconds
+
+/**
+ * A hashed timer wheel allowing many coroutines to wait for short durations using a single timer.
+ *
+ * Time is divided into ticks of [tickDuration]. Waiters are placed into the slot of the tick at
+ * which they expire (rounded up), and a single coroutine launched in [scope] advances the wheel
+ * while waiters exist. All waiters expiring in the same tick are resumed together, which aligns
+ * work scheduled by them (like re-running throttled queries).
+ */
+@OptIn(InternalAPI::class)
+internal class TimerWheel(
+    private val scope: CoroutineScope,
+    private val tickDuration: Duration = DEFAULT_TICK,
+    wheelSize: Int = DEFAULT_WHEEL_SIZE,
+) : SynchronizedObject() {
+    // All fields below are guarded by synchronizing on this wheel.
+    private val slots = Array(wheelSize) { mutableListOf<Timer>() }
+    private var currentTick = 0L
+    private var pending = 0
+    private var ticker: Job? = null
+
+    init {
+        require(tickDuration.isPositive()) { "tickDuration must be positive" }
+    }
+
+    /**
+     * Suspends for [duration], rounded up to a whole number of ticks.
+     *
+     * Since ticks are counted from the last tick of the wheel rather than from this call, the
+     * actual delay may be up to one tick shorter. If [scope] is cancelled, pending waiters are
+     * resumed early and later calls fall back to a timer per waiter.
+     */
+    suspend fun delay(duration: Duration) {
+        if (!duration.isPositive()) {
+            return
+        }
+
+        if (scope.coroutineContext[Job]?.isActive == false) {
+            return kotlinx.coroutines.delay(duration)
+        }
+
+        val ticks = ((duration.inWholeNanoseconds + tickDuration.inWholeNanoseconds - 1) / tickDuration.inWholeNanoseconds)
+        suspendCancellableCoroutine { continuation ->
+            var startedTicker: Job? = null
+            val timer =
+                synchronized(this) {
+                    Timer(currentTick + ticks, continuation).also {
+                        slotFor(it.deadline).add(it)
+                        pending++
+                        if (ticker == null) {
+                            startedTicker = scope.launch { runTicker() }.also { job -> ticker = job }
+                        }
+                    }
+                }
+
+            // Registered outside of the lock since the handler runs immediately if the ticker
+            // couldn't start.
+            startedTicker?.let { job -> job.invokeOnCompletion { onTickerCompleted(job) } }
+
+            continuation.invokeOnCancellation {
+                synchronized(this) {
+                    if (slotFor(timer.deadline).remove(timer)) {
+                        pending--
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * Resumes all pending waiters if [job] stopped without expiring them, which happens when
+     * [scope] is cancelled.
+     */
+    private fun onTickerCompleted(job: Job) {
+        val waiters =
+            synchronized(this) {
+                // Tickers finishing normally have already been replaced or cleared.
+                if (ticker !== job) return
+
+                ticker = null
+                pending = 0
+                slots.flatMap { slot -> slot.toList().also { slot.clear() } }
+            }
+
+        waiters.forEach { it.continuation.resume(Unit) }
+    }
+
+    private suspend fun runTicker() {
+        val expired = mutableListOf<Timer>()
+        while (true) {
+            kotlinx.coroutines.delay(tickDuration)
+
+            val keepRunning =
+                synchronized(this) {
+                    currentTick++
+                    val iterator = slotFor(currentTick).iterator()
+                    while (iterator.hasNext()) {
+                        val timer = iterator.next()
+                        // Timers further than one rotation away stay in the slot.
+                        if (timer.deadline <= currentTick) {
+                            iterator.remove()
+                            expired.add(timer)
+                        }
+                    }
+                    pending -= expired.size
+
+                    (pending > 0).also { if (!it) ticker = null }
+                }
+
+            expired.forEach { it.continuation.resume(Unit) }
+            expired.clear()
+            if (!keepRunning) break
+        }
+    }
+
+    private fun slotFor(tick: Long): MutableList<Timer> = slots[(tick % slots.size).toInt()]
+
+    private class Timer(
+        val deadline: Long,
+        val continuation: CancellableContinuation<Unit>,
+    )
+
+    private companion object {
+        val DEFAULT_TICK = 10.milliseconds
+        const val DEFAULT_WHEEL_SIZE = 512
+    }
+}
@@ -0,0 +1,35 @@
+package powersync.attachments
+
+import com.powersync.attachments.storage.IOLocalStorageAdapter
+import com.powersync.test.getTempDir
+import io.kotest.matchers.shouldBe
+import kotlinx.coroutines.flow.flowOf
+import kotlinx.coroutines.flow.toList
+import kotlinx.coroutines.test.runTest
+import kotlinx.io.files.Path
+import kotlin.random.Random
+import kotlin.test.Test
+
+class IOLocalStorageAdapterTest {
+    @Test
+    fun readsFilesInFixedSizeChunks() =
+        runTest {
+            val storage = IOLocalStorageAdapter(readChunkSize = 1000)
+            val path = Path(getTempDir(), "io-local-storage-${Random.nextLong()}").toString()
+            val contents = Random.nextBytes(2500)
+
+            // Chunks of uneven sizes, including empty ones, are written as-is.
+            val written =
+                storage.saveFile(
+                    path,
+                    flowOf(contents.copyOfRange(0, 10), ByteArray(0), contents.copyOfRange(10, 2500)),
+                )
+            written shouldBe 2500L
+
+            val chunks = storage.readFile(path).toList()
+            chunks.map { it.size } shouldBe listOf(1000, 1000, 500)
+            chunks.reduce { acc, bytes -> acc + bytes }.contentEquals(contents) shouldBe true
+
+            storage.deleteFile(path)
+        }
+}
@@ -0,0 +1,135 @@
+package powersync.attachments
+
+import com.powersync.attachments.Attachment
+import com.powersync.attachments.AttachmentState
+import com.powersync.attachments.WatchedAttachmentItem
+import com.powersync.attachments.implementation.reconcileWatchedAttachments
+import io.kotest.matchers.collections.shouldBeEmpty
+import io.kotest.matchers.shouldBe
+import kotlinx.coroutines.test.runTest
+import kotlin.test.Test
+
+class WatchedAttachmentsReconcilerTest {
+    private suspend fun reconcile(
+        current: List<Attachment>,
+        items: List<WatchedAttachmentItem>,
+        downloadAttachments: Boolean = true,
+    ): List<Attachment> =
+        reconcileWatchedAttachments(
+            current = current,
+            items = items,
+            downloadAttachments = downloadAttachments,
+            resolveFilename = { id, extension -> "$id.$extension" },
+        )
+
+    private fun attachment(
+        id: String,
+        state: AttachmentState,
+        hasSynced: Boolean = false,
+        localUri: String? = null,
+    ) = Attachment(
+        id = id,
+        filename = "$id.jpg",
+        state = state,
+        localUri = localUri,
+        hasSynced = hasSynced,
+    )
+
+    @Test
+    fun queuesNewItems() =
+        runTest {
+            val updates =
+                reconcile(
+                    current = emptyList(),
+                    items = listOf(WatchedAttachmentItem(id = "a", fileExtension = "jpg")),
+                )
+
+            updates.map { it.id to it.state } shouldBe listOf("a" to AttachmentState.QUEUED_DOWNLOAD)
+            updates.single().filename shouldBe "a.jpg"
+        }
+
+    @Test
+    fun doesNotQueueNewItemsWithoutDownloads() =
+        runTest {
+            reconcile(
+                current = emptyList(),
+                items = listOf(WatchedAttachmentItem(id = "a", fileExtension = "jpg")),
+                downloadAttachments = false,
+            ).shouldBeEmpty()
+        }
+
+    @Test
+    fun skipsDuplicateItems() =
+        runTest {
+            val updates =
+                reconcile(
+                    current = emptyList(),
+                    items =
+                        listOf(
+                            WatchedAttachmentItem(id = "a", fileExtension = "jpg"),
+                            WatchedAttachmentItem(id = "a", fileExtension = "jpg"),
+                        ),
+                )
+
+            updates.map { it.id } shouldBe listOf("a")
+        }
+
+    @Test
+    fun leavesWatchedAttachmentsUnchanged() =
+        runTest {
+            reconcile(
+                current = listOf(attachment("a", AttachmentState.SYNCED, hasSynced = true, localUri = "a.jpg")),
+                items = listOf(WatchedAttachmentItem(id = "a", fileExtension = "jpg")),
+            ).shouldBeEmpty()
+        }
+
+    @Test
+    fun archivesRemovedItems() =
+        runTest {
+            val updates =
+                reconcile(
+                    current =
+                        listOf(
+                            attachment("synced", AttachmentState.SYNCED, hasSynced = true, localUri = "synced.jpg"),
+                            attachment("download", AttachmentState.QUEUED_DOWNLOAD),
+                            attachment("pending-upload", AttachmentState.QUEUED_UPLOAD),
+                            attachment("archived", AttachmentState.ARCHIVED, hasSynced = true),
+                        ),
+                    items = emptyList(),
+                )
+
+            // Uploads that haven't synced yet and attachments that are already archived are kept as-is.
+            updates.map { it.id to it.state } shouldBe
+                listOf(
+                    "synced" to AttachmentState.ARCHIVED,
+                    "download" to AttachmentState.ARCHIVED,
+                )
+        }
+
+    @Test
+    fun restoresArchivedItems() =
+        runTest {
+            val updates =
+                reconcile(
+                    current =
+                        listOf(
+                            attachment("synced", AttachmentState.ARCHIVED, hasSynced = true, localUri = "synced.jpg"),
+                            attachment("download", AttachmentState.ARCHIVED),
+                            attachment("upload", AttachmentState.ARCHIVED, localUri = "upload.jpg"),
+                        ),
+                    items =
+                        listOf(
+                            WatchedAttachmentItem(id = "synced", fileExtension = "jpg"),
+                            WatchedAttachmentItem(id = "download", fileExtension = "jpg"),
+                            WatchedAttachmentItem(id = "upload", fileExtension = "jpg"),
+                        ),
+                )
+
+            updates.map { it.id to it.state } shouldBe
+                listOf(
+                    "synced" to AttachmentState.SYNCED,
+                    "download" to AttachmentState.QUEUED_DOWNLOAD,
+                    "upload" to AttachmentState.QUEUED_UPLOAD,
+                )
+        }
+}
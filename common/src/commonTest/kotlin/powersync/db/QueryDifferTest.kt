@@ -0,0 +1,78 @@
+package powersync.db
+
+import com.powersync.ExperimentalPowerSyncAPI
+import com.powersync.PowerSyncException
+import com.powersync.db.RowDiff
+import com.powersync.db.getString
+import com.powersync.db.internal.MaterializedRows
+import com.powersync.db.internal.QueryDiffer
+import io.kotest.assertions.throwables.shouldThrow
+import io.kotest.matchers.shouldBe
+import io.kotest.matchers.types.shouldBeSameInstanceAs
+import kotlin.test.Test
+
+@OptIn(ExperimentalPowerSyncAPI::class)
+class QueryDifferTest {
+    private var mapped = 0
+
+    private fun differ() =
+        QueryDiffer("id") {
+            mapped++
+            Item(it.getString("id"), it.getString("name"))
+        }
+
+    private fun result(vararg rows: Pair<String, String>) =
+        MaterializedRows(listOf("id", "name"), rows.map { (id, name) -> arrayOf<Any?>(id, name) })
+
+    @Test
+    fun reportsInitialRowsAsInserted() {
+        val diff = differ().apply(result("a" to "A", "b" to "B"))
+
+        diff.rows shouldBe listOf(Item("a", "A"), Item("b", "B"))
+        diff.changes shouldBe
+            listOf(
+                RowDiff.Inserted(0, Item("a", "A")),
+                RowDiff.Inserted(1, Item("b", "B")),
+            )
+    }
+
+    @Test
+    fun onlyMapsChangedRows() {
+        val differ = differ()
+        val first = differ.apply(result("a" to "A", "b" to "B", "c" to "C"))
+        mapped = 0
+
+        val diff = differ.apply(result("a" to "A", "b" to "B2", "d" to "D"))
+        mapped shouldBe 2
+        diff.rows[0] shouldBeSameInstanceAs first.rows[0]
+        diff.changes shouldBe
+            listOf(
+                RowDiff.Removed(2, Item("c", "C")),
+                RowDiff.Updated(1, Item("b", "B"), Item("b", "B2")),
+                RowDiff.Inserted(2, Item("d", "D")),
+            )
+    }
+
+    @Test
+    fun reportsMoves() {
+        val differ = differ()
+        differ.apply(result("a" to "A", "b" to "B", "c" to "C", "d" to "D"))
+        mapped = 0
+
+        val diff = differ.apply(result("b" to "B", "c" to "C", "d" to "D", "a" to "A"))
+        mapped shouldBe 0
+        diff.changes shouldBe listOf(RowDiff.Moved(0, 3, Item("a", "A")))
+    }
+
+    @Test
+    fun rejectsDuplicateKeys() {
+        shouldThrow<PowerSyncException> {
+            differ().apply(result("a" to "A", "a" to "B"))
+        }
+    }
+
+    private data class Item(
+        val id: String,
+        val name: String,
+    )
+}
@@ -0,0 +1,177 @@
+package powersync.db
+
+import androidx.sqlite.SQLiteConnection
+import androidx.sqlite.SQLiteStatement
+import com.powersync.ExperimentalPowerSyncAPI
+import com.powersync.PowerSyncException
+import com.powersync.db.driver.ReadPool
+import com.powersync.db.driver.ReadPoolMetrics
+import com.powersync.db.driver.ReadPoolOptions
+import com.powersync.db.driver.ReadPriority
+import io.kotest.assertions.throwables.shouldThrow
+import io.kotest.matchers.shouldBe
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.test.TestScope
+import kotlinx.coroutines.test.advanceTimeBy
+import kotlinx.coroutines.test.runCurrent
+import kotlinx.coroutines.test.runTest
+import kotlinx.coroutines.withContext
+import kotlin.test.Test
+import kotlin.time.Duration
+import kotlin.time.Duration.Companion.seconds
+
+@OptIn(ExperimentalPowerSyncAPI::class)
+class ReadPoolTest {
+    private val opened = mutableListOf<FakeConnection>()
+
+    private fun CoroutineScope.pool(options: ReadPoolOptions) =
+        ReadPool(
+            factory = { FakeConnection().also(opened::add) },
+            options = options,
+            scope = this,
+        )
+
+    @Test
+    fun opensConnectionsOnDemand() =
+        runTest {
+            val pool = pool(ReadPoolOptions(minSize = 0, maxSize = 2))
+            opened.size shouldBe 0
+
+            val inRead = CompletableDeferred<Unit>()
+            val release = CompletableDeferred<Unit>()
+            launch {
+                pool.read {
+                    inRead.complete(Unit)
+                    release.await()
+                }
+            }
+            inRead.await()
+            pool.read { }
+
+            opened.size shouldBe 2
+            release.complete(Unit)
+            pool.close()
+        }
+
+    @Test
+    fun servesInteractiveReadsFirst() =
+        runTest {
+            val pool = pool(ReadPoolOptions(minSize = 1, maxSize = 1, backgroundAgingThreshold = Duration.INFINITE))
+            val order = mutableListOf<String>()
+            val release = CompletableDeferred<Unit>()
+
+            launch { pool.read { release.await() } }
+            runCurrent()
+
+            launch {
+                withContext(ReadPriority.BACKGROUND) {
+                    pool.read { order.add("background") }
+                }
+            }
+            runCurrent()
+            launch { pool.read { order.add("interactive") } }
+            runCurrent()
+
+            release.complete(Unit)
+            runCurrent()
+            order shouldBe listOf("interactive", "background")
+            pool.close()
+        }
+
+    @Test
+    fun agesBackgroundReads() =
+        runTest {
+            val pool = pool(ReadPoolOptions(minSize = 1, maxSize = 1, backgroundAgingThreshold = Duration.ZERO))
+            val order = mutableListOf<String>()
+            val release = CompletableDeferred<Unit>()
+
+            launch { pool.read { release.await() } }
+            runCurrent()
+
+            launch {
+                withContext(ReadPriority.BACKGROUND) {
+                    pool.read { order.add("background") }
+                }
+            }
+            runCurrent()
+            launch { pool.read { order.add("interactive") } }
+            runCurrent()
+
+            release.complete(Unit)
+            runCurrent()
+            order shouldBe listOf("background", "interactive")
+            pool.close()
+        }
+
+    @Test
+    fun closesIdleConnections() =
+        runTest {
+            val metrics = ReadPoolMetrics()
+            val pool = pool(ReadPoolOptions(minSize = 1, maxSize = 3, idleTimeout = 10.seconds, metrics = metrics))
+            openConcurrently(pool, 3)
+            metrics.state.value.idleConnections shouldBe 3
+
+            advanceTimeBy(25.seconds)
+            runCurrent()
+            metrics.state.value.openConnections shouldBe 1
+            opened.count { it.closed } shouldBe 2
+
+            pool.close()
+            opened.all { it.closed } shouldBe true
+        }
+
+    @Test
+    fun withAllConnectionsWaitsForReaders() =
+        runTest {
+            val pool = pool(ReadPoolOptions(minSize = 0, maxSize = 3))
+            openConcurrently(pool, 2)
+
+            val release = CompletableDeferred<Unit>()
+            launch { pool.read { release.await() } }
+            runCurrent()
+
+            var connections = -1
+            launch { pool.withAllConnections { connections = it.size } }
+            runCurrent()
+            connections shouldBe -1
+
+            release.complete(Unit)
+            runCurrent()
+            connections shouldBe 2
+            pool.close()
+        }
+
+    @Test
+    fun rejectsReadsAfterClose() =
+        runTest {
+            val pool = pool(ReadPoolOptions())
+            pool.close()
+
+            shouldThrow<PowerSyncException> { pool.read { } }
+        }
+
+    private suspend fun TestScope.openConcurrently(
+        pool: ReadPool,
+        count: Int,
+    ) {
+        val release = CompletableDeferred<Unit>()
+        val jobs = List(count) { launch { pool.read { release.await() } } }
+        runCurrent()
+        release.complete(Unit)
+        jobs.forEach { it.join() }
+    }
+
+    private class FakeConnection : SQLiteConnection {
+        var closed = false
+
+        override fun inTransaction(): Boolean = false
+
+        override fun prepare(sql: String): SQLiteStatement = throw UnsupportedOperationException()
+
+        override fun close() {
+            closed = true
+        }
+    }
+}
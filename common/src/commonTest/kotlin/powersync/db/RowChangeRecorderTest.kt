@@ -0,0 +1,84 @@
+package powersync.db
+
+import androidx.sqlite.SQLiteStatement
+import com.powersync.ExperimentalPowerSyncAPI
+import com.powersync.db.RowChangeset
+import com.powersync.db.driver.ChangesetSession
+import com.powersync.db.driver.RowChangeRecorder
+import com.powersync.db.driver.SessionRecordingConnection
+import io.kotest.matchers.collections.shouldBeEmpty
+import io.kotest.matchers.shouldBe
+import kotlinx.coroutines.flow.toList
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.test.UnconfinedTestDispatcher
+import kotlinx.coroutines.test.runTest
+import kotlin.test.Test
+
+@OptIn(ExperimentalPowerSyncAPI::class)
+class RowChangeRecorderTest {
+    @Test
+    fun emitsChangesOfWrites() =
+        runTest {
+            val connection = FakeConnection()
+            val recorder = RowChangeRecorder(connection)
+            val emitted = mutableListOf<RowChangeset>()
+            backgroundScope.launch(UnconfinedTestDispatcher(testScheduler)) { recorder.rowChanges.toList(emitted) }
+
+            recorder.beforeWrite()
+            connection.sessions.last().changes = byteArrayOf(1)
+            recorder.afterWrite()
+
+            emitted.map { it.bytes.toList() } shouldBe listOf(listOf<Byte>(1))
+            // Changes of the next write are recorded in a new session.
+            connection.sessions.map { it.closed } shouldBe listOf(true, false)
+        }
+
+    @Test
+    fun keepsSessionWithoutChanges() =
+        runTest {
+            val connection = FakeConnection()
+            val recorder = RowChangeRecorder(connection)
+            val emitted = mutableListOf<RowChangeset>()
+            backgroundScope.launch(UnconfinedTestDispatcher(testScheduler)) { recorder.rowChanges.toList(emitted) }
+
+            recorder.beforeWrite()
+            recorder.afterWrite()
+
+            emitted.shouldBeEmpty()
+            connection.sessions.map { it.closed } shouldBe listOf(false)
+        }
+
+    @Test
+    fun doesNotRecordWithoutSubscribers() {
+        val connection = FakeConnection()
+        val recorder = RowChangeRecorder(connection)
+
+        recorder.beforeWrite()
+        recorder.afterWrite()
+
+        connection.sessions.shouldBeEmpty()
+    }
+
+    private class FakeConnection : SessionRecordingConnection {
+        val sessions = mutableListOf<FakeSession>()
+
+        override fun openChangesetSession(): ChangesetSession = FakeSession().also { sessions.add(it) }
+
+        override fun inTransaction(): Boolean = false
+
+        override fun prepare(sql: String): SQLiteStatement = throw UnsupportedOperationException()
+
+        override fun close() {}
+    }
+
+    private class FakeSession : ChangesetSession {
+        var changes: ByteArray? = null
+        var closed = false
+
+        override fun changeset(): ByteArray? = changes
+
+        override fun close() {
+            closed = true
+        }
+    }
+}
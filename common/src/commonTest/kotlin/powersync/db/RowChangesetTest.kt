@@ -0,0 +1,178 @@
+package powersync.db
+
+import com.powersync.ExperimentalPowerSyncAPI
+import com.powersync.db.RowChange
+import com.powersync.db.RowChangeset
+import io.kotest.matchers.collections.shouldHaveSize
+import io.kotest.matchers.shouldBe
+import io.kotest.matchers.shouldNotBe
+import kotlin.test.Test
+
+@OptIn(ExperimentalPowerSyncAPI::class)
+class RowChangesetTest {
+    @Test
+    fun decodesChanges() {
+        val changeset =
+            RowChangeset(
+                changeset {
+                    table("ps_data__users", 2)
+                    // INSERT INTO users (id, data) VALUES ('a', '{}')
+                    change(18) {
+                        text("a")
+                        text("{}")
+                    }
+                    // UPDATE users SET data = '{"n":1}' WHERE id = 'a'
+                    change(23) {
+                        text("a")
+                        text("{}")
+                        undefined()
+                        text("{\"n\":1}")
+                    }
+                    // DELETE FROM users WHERE id = 'b'
+                    change(9) {
+                        text("b")
+                        nullValue()
+                    }
+                },
+            )
+
+        val changes = changeset.changes()
+        changes shouldHaveSize 3
+
+        changes[0].run {
+            table shouldBe "ps_data__users"
+            operation shouldBe RowChange.Operation.INSERT
+            primaryKey shouldBe listOf("a")
+            oldValues shouldBe emptyMap()
+            newValues shouldBe mapOf(0 to "a", 1 to "{}")
+        }
+
+        changes[1].run {
+            operation shouldBe RowChange.Operation.UPDATE
+            primaryKey shouldBe listOf("a")
+            oldValues shouldBe mapOf(0 to "a", 1 to "{}")
+            newValues shouldBe mapOf(1 to "{\"n\":1}")
+        }
+
+        changes[2].run {
+            operation shouldBe RowChange.Operation.DELETE
+            primaryKey shouldBe listOf("b")
+            oldValues shouldBe mapOf(0 to "b", 1 to null)
+        }
+    }
+
+    @Test
+    fun decodesNumbersAndBlobs() {
+        val changes =
+            RowChangeset(
+                changeset {
+                    table("numbers", 3)
+                    change(18) {
+                        integer(-2)
+                        real(1.5)
+                        blob(byteArrayOf(1, 2, 3))
+                    }
+                },
+            ).changes()
+
+        changes shouldHaveSize 1
+        val values = changes[0].newValues
+        values[0] shouldBe -2L
+        values[1] shouldBe 1.5
+        (values[2] as ByteArray).toList() shouldBe listOf<Byte>(1, 2, 3)
+    }
+
+    @Test
+    fun filtersTables() {
+        val changeset =
+            RowChangeset(
+                changeset {
+                    table("ps_data__users", 2)
+                    change(18) {
+                        text("a")
+                        text("{}")
+                    }
+                    table("ps_data__lists", 2)
+                    change(9) {
+                        text("b")
+                        text("{}")
+                    }
+                },
+            )
+
+        changeset.filterTables(setOf("ps_data__users", "ps_data__lists")) shouldBe changeset
+        changeset.filterTables(setOf("ps_data__todos")) shouldBe null
+
+        val filtered = changeset.filterTables(setOf("ps_data__lists"))
+        filtered shouldNotBe null
+        filtered!!.changes().map { it.table to it.operation } shouldBe
+            listOf("ps_data__lists" to RowChange.Operation.DELETE)
+    }
+
+    private class ChangesetBuilder {
+        val bytes = mutableListOf<Byte>()
+
+        fun table(
+            name: String,
+            columns: Int,
+        ) {
+            bytes.add('T'.code.toByte())
+            bytes.add(columns.toByte())
+            // The first column is the primary key.
+            repeat(columns) { bytes.add(if (it == 0) 1.toByte() else 0.toByte()) }
+            bytes.addAll(name.encodeToByteArray().toList())
+            bytes.add(0)
+        }
+
+        fun change(
+            op: Int,
+            values: ChangesetBuilder.() -> Unit,
+        ) {
+            bytes.add(op.toByte())
+            bytes.add(0)
+            values()
+        }
+
+        fun undefined() {
+            bytes.add(0)
+        }
+
+        fun nullValue() {
+            bytes.add(5)
+        }
+
+        fun integer(value: Long) {
+            bytes.add(1)
+            addInt64(value)
+        }
+
+        fun real(value: Double) {
+            bytes.add(2)
+            addInt64(value.toRawBits())
+        }
+
+        fun text(value: String) {
+            bytes.add(3)
+            addLengthPrefixed(value.encodeToByteArray())
+        }
+
+        fun blob(value: ByteArray) {
+            bytes.add(4)
+            addLengthPrefixed(value)
+        }
+
+        private fun addLengthPrefixed(value: ByteArray) {
+            // All values in these tests are shorter than 128 bytes, so the varint is a single byte.
+            bytes.add(value.size.toByte())
+            bytes.addAll(value.toList())
+        }
+
+        private fun addInt64(value: Long) {
+            for (shift in 56 downTo 0 step 8) {
+                bytes.add((value shr shift).toByte())
+            }
+        }
+    }
+
+    private fun changeset(block: ChangesetBuilder.() -> Unit): ByteArray = ChangesetBuilder().apply(block).bytes.toByteArray()
+}
@@ -0,0 +1,42 @@
+package powersync.db
+
+import com.powersync.db.internal.SourceTableCache
+import io.kotest.matchers.shouldBe
+import kotlin.test.Test
+
+class SourceTableCacheTest {
+    @Test
+    fun returnsEntriesForSameSchemaVersion() {
+        val cache = SourceTableCache()
+        cache.put("SELECT * FROM users", 1, setOf("ps_data__users"))
+
+        cache.get("SELECT * FROM users", 1) shouldBe setOf("ps_data__users")
+        cache.get("SELECT * FROM lists", 1) shouldBe null
+    }
+
+    @Test
+    fun discardsEntriesWhenSchemaChanges() {
+        val cache = SourceTableCache()
+        cache.put("SELECT * FROM users", 1, setOf("ps_data__users"))
+        cache.get("SELECT * FROM users", 2) shouldBe null
+
+        cache.put("SELECT * FROM lists", 2, setOf("ps_data__lists"))
+        cache.get("SELECT * FROM users", 1) shouldBe null
+        cache.get("SELECT * FROM lists", 2) shouldBe setOf("ps_data__lists")
+
+        cache.invalidate()
+        cache.get("SELECT * FROM lists", 2) shouldBe null
+    }
+
+    @Test
+    fun evictsOldestEntries() {
+        val cache = SourceTableCache(maxEntries = 2)
+        cache.put("a", 1, setOf("a"))
+        cache.put("b", 1, setOf("b"))
+        cache.put("c", 1, setOf("c"))
+
+        cache.get("a", 1) shouldBe null
+        cache.get("b", 1) shouldBe setOf("b")
+        cache.get("c", 1) shouldBe setOf("c")
+    }
+}
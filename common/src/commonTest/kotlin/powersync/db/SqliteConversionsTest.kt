@@ -0,0 +1,49 @@
+package powersync.db
+
+import com.powersync.db.internal.SqliteConversions
+import io.kotest.matchers.shouldBe
+import kotlin.test.Test
+
+class SqliteConversionsTest {
+    @Test
+    fun textToLong() {
+        SqliteConversions.textToLong("42") shouldBe 42L
+        SqliteConversions.textToLong(" \t-12abc") shouldBe -12L
+        SqliteConversions.textToLong("+7") shouldBe 7L
+        SqliteConversions.textToLong("1e5") shouldBe 1L
+        SqliteConversions.textToLong("abc") shouldBe 0L
+        SqliteConversions.textToLong("") shouldBe 0L
+        SqliteConversions.textToLong("9223372036854775807") shouldBe Long.MAX_VALUE
+        SqliteConversions.textToLong("9223372036854775808") shouldBe Long.MAX_VALUE
+        SqliteConversions.textToLong("-9223372036854775808") shouldBe Long.MIN_VALUE
+        SqliteConversions.textToLong("-100000000000000000000") shouldBe Long.MIN_VALUE
+    }
+
+    @Test
+    fun textToDouble() {
+        SqliteConversions.textToDouble("1.5") shouldBe 1.5
+        SqliteConversions.textToDouble(" 12abc") shouldBe 12.0
+        SqliteConversions.textToDouble("-.5") shouldBe -0.5
+        SqliteConversions.textToDouble("3.") shouldBe 3.0
+        SqliteConversions.textToDouble("1e3x") shouldBe 1000.0
+        SqliteConversions.textToDouble("2E-2") shouldBe 0.02
+        SqliteConversions.textToDouble("4e") shouldBe 4.0
+        SqliteConversions.textToDouble(".") shouldBe 0.0
+        SqliteConversions.textToDouble("abc") shouldBe 0.0
+    }
+
+    @Test
+    fun realToText() {
+        SqliteConversions.realToText(0.0) shouldBe "0.0"
+        SqliteConversions.realToText(100.0) shouldBe "100.0"
+        SqliteConversions.realToText(-1.25) shouldBe "-1.25"
+        SqliteConversions.realToText(0.1 + 0.2) shouldBe "0.3"
+        SqliteConversions.realToText(0.0001) shouldBe "0.0001"
+        SqliteConversions.realToText(0.00001) shouldBe "1.0e-05"
+        SqliteConversions.realToText(1e20) shouldBe "1.0e+20"
+        SqliteConversions.realToText(123456789012345.0) shouldBe "123456789012345.0"
+        SqliteConversions.realToText(1234567890123456.0) shouldBe "1.23456789012346e+15"
+        SqliteConversions.realToText(999999999999999.9) shouldBe "1.0e+15"
+        SqliteConversions.realToText(Double.POSITIVE_INFINITY) shouldBe "Inf"
+    }
+}
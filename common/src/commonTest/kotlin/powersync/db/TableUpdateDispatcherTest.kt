@@ -0,0 +1,88 @@
+package powersync.db
+
+import com.powersync.db.internal.TableUpdateDispatcher
+import io.kotest.assertions.throwables.shouldThrow
+import io.kotest.matchers.shouldBe
+import kotlinx.coroutines.awaitCancellation
+import kotlinx.coroutines.flow.MutableSharedFlow
+import kotlinx.coroutines.flow.flow
+import kotlinx.coroutines.test.runCurrent
+import kotlinx.coroutines.test.runTest
+import kotlin.test.Test
+
+class TableUpdateDispatcherTest {
+    @Test
+    fun onlyWakesAffectedSubscribers() =
+        runTest {
+            val updates = MutableSharedFlow<Set<String>>()
+            val dispatcher = TableUpdateDispatcher(updates, backgroundScope)
+            val users = dispatcher.subscribe(listOf("users"))
+            val lists = dispatcher.subscribe(listOf("lists", "todos"))
+
+            updates.emit(setOf("todos", "unrelated"))
+            runCurrent()
+
+            users.wakeups.tryReceive().isSuccess shouldBe false
+            lists.wakeups.tryReceive().isSuccess shouldBe true
+            lists.takeChangedTables() shouldBe setOf("todos")
+            lists.takeChangedTables() shouldBe emptySet()
+
+            users.close()
+            lists.close()
+        }
+
+    @Test
+    fun conflatesUpdates() =
+        runTest {
+            val updates = MutableSharedFlow<Set<String>>()
+            val dispatcher = TableUpdateDispatcher(updates, backgroundScope)
+            val subscription = dispatcher.subscribe(listOf("lists", "todos"))
+
+            updates.emit(setOf("lists"))
+            updates.emit(setOf("todos"))
+            runCurrent()
+
+            subscription.wakeups.tryReceive().isSuccess shouldBe true
+            subscription.wakeups.tryReceive().isSuccess shouldBe false
+            subscription.takeChangedTables() shouldBe setOf("lists", "todos")
+            subscription.close()
+        }
+
+    @Test
+    fun stopsCollectingWithoutSubscribers() =
+        runTest {
+            val updates = MutableSharedFlow<Set<String>>()
+            val dispatcher = TableUpdateDispatcher(updates, backgroundScope)
+
+            val subscription = dispatcher.subscribe(listOf("users"))
+            updates.subscriptionCount.value shouldBe 1
+
+            subscription.close()
+            runCurrent()
+            updates.subscriptionCount.value shouldBe 0
+        }
+
+    @Test
+    fun closesSubscriptionsWhenCollectingFails() =
+        runTest {
+            var attempts = 0
+            val updates =
+                flow<Set<String>> {
+                    if (attempts++ == 0) throw IllegalStateException("could not open database")
+                    emit(setOf("users"))
+                    awaitCancellation()
+                }
+            val dispatcher = TableUpdateDispatcher(updates, backgroundScope)
+
+            // The failure is reported to subscribers instead of the scope running the collector.
+            val failed = dispatcher.subscribe(listOf("users"))
+            shouldThrow<IllegalStateException> { failed.wakeups.receive() }.message shouldBe "could not open database"
+            failed.close()
+
+            // Later subscriptions collect updates again.
+            val subscription = dispatcher.subscribe(listOf("users"))
+            runCurrent()
+            subscription.takeChangedTables() shouldBe setOf("users")
+            subscription.close()
+        }
+}
@@ -0,0 +1,76 @@
+package powersync.sync
+
+import com.powersync.ExperimentalPowerSyncAPI
+import com.powersync.sync.AdaptiveRequestStrategy
+import com.powersync.sync.PrefetchBufferState
+import com.powersync.sync.RSocketFlowControl
+import io.kotest.matchers.shouldBe
+import io.rsocket.kotlin.ExperimentalStreamsApi
+import kotlinx.coroutines.async
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.test.runCurrent
+import kotlinx.coroutines.test.runTest
+import kotlin.test.Test
+import kotlin.time.Duration.Companion.milliseconds
+
+@OptIn(ExperimentalPowerSyncAPI::class, ExperimentalStreamsApi::class)
+class AdaptiveRequestStrategyTest {
+    private val options = RSocketFlowControl(initialRequest = 8, maxRequest = 100, targetBacklog = 100.milliseconds)
+
+    @Test
+    fun limitsWindowByApplyLatency() {
+        val buffer = MutableStateFlow(PrefetchBufferState(capacityBytes = 1_000_000))
+        val strategy = AdaptiveRequestStrategy(options, buffer)
+        strategy.window() shouldBe 8
+
+        strategy.recordReceived(1000)
+        // Fast database: the window is only limited by maxRequest.
+        strategy.recordApplied(1000, 0.milliseconds)
+        strategy.window() shouldBe 100
+
+        // Applying a line takes 10ms, so 10 lines keep the database busy for the target backlog.
+        val slow = AdaptiveRequestStrategy(options, buffer)
+        slow.recordReceived(1000)
+        slow.recordApplied(1000, 10.milliseconds)
+        slow.window() shouldBe 10
+    }
+
+    @Test
+    fun limitsWindowByBufferedBytes() {
+        val buffer = MutableStateFlow(PrefetchBufferState(bufferedBytes = 15_000, capacityBytes = 20_000))
+        val strategy = AdaptiveRequestStrategy(options, buffer)
+        strategy.recordReceived(1000)
+
+        strategy.window() shouldBe 5
+    }
+
+    @Test
+    fun topsUpAfterHalfOfTheWindowArrived() =
+        runTest {
+            val buffer = MutableStateFlow(PrefetchBufferState(capacityBytes = 1_000_000))
+            val strategy = AdaptiveRequestStrategy(options, buffer)
+            val element = strategy.provide()
+
+            element.firstRequest() shouldBe 8
+            repeat(3) { element.nextRequest() shouldBe 0 }
+            // 4 lines outstanding, request 4 more to fill the window again.
+            element.nextRequest() shouldBe 4
+        }
+
+    @Test
+    fun waitsForBufferBeforeStalling() =
+        runTest {
+            val buffer = MutableStateFlow(PrefetchBufferState(bufferedBytes = 10_000, capacityBytes = 10_000))
+            val strategy = AdaptiveRequestStrategy(RSocketFlowControl(initialRequest = 1), buffer)
+            val element = strategy.provide()
+            element.firstRequest() shouldBe 1
+
+            val next = async { element.nextRequest() }
+            runCurrent()
+            next.isCompleted shouldBe false
+
+            buffer.value = PrefetchBufferState(capacityBytes = 10_000)
+            runCurrent()
+            next.await() shouldBe 1
+        }
+}
@@ -0,0 +1,74 @@
+package powersync.sync
+
+import com.powersync.ExperimentalPowerSyncAPI
+import com.powersync.bucket.PowerSyncControlArguments
+import com.powersync.sync.ControlQueue
+import com.powersync.sync.SyncMetrics
+import io.kotest.matchers.shouldBe
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.test.runCurrent
+import kotlinx.coroutines.test.runTest
+import kotlin.test.Test
+
+@OptIn(ExperimentalPowerSyncAPI::class)
+class ControlQueueTest {
+    @Test
+    fun suspendsWhenBudgetIsExhausted() =
+        runTest {
+            val metrics = SyncMetrics()
+            val queue = ControlQueue(capacityBytes = 10, metrics = metrics)
+            var sent = 0
+
+            launch {
+                repeat(3) {
+                    queue.send(PowerSyncControlArguments.TextLine("abcd"))
+                    sent++
+                }
+            }
+            runCurrent()
+
+            // Two lines fit into the budget, the third one has to wait.
+            sent shouldBe 2
+            metrics.prefetchBuffer.value.run {
+                bufferedLines shouldBe 2
+                bufferedBytes shouldBe 8
+                backpressureStalls shouldBe 1
+            }
+
+            queue.receiveOrNull() shouldBe PowerSyncControlArguments.TextLine("abcd")
+            runCurrent()
+            sent shouldBe 3
+            metrics.prefetchBuffer.value.run {
+                bufferedLines shouldBe 2
+                peakBufferedBytes shouldBe 8
+            }
+        }
+
+    @Test
+    fun admitsLargeLineIntoEmptyBuffer() =
+        runTest {
+            val queue = ControlQueue(capacityBytes = 2)
+            queue.send(PowerSyncControlArguments.TextLine("larger than the budget"))
+
+            queue.bufferState.value.bufferedLines shouldBe 1
+            queue.tryReceive() shouldBe PowerSyncControlArguments.TextLine("larger than the budget")
+            queue.bufferState.value.bufferedBytes shouldBe 0
+        }
+
+    @Test
+    fun otherArgumentsBypassBudget() =
+        runTest {
+            val queue = ControlQueue(capacityBytes = 4)
+            queue.send(PowerSyncControlArguments.TextLine("abcd"))
+            queue.send(PowerSyncControlArguments.CompletedUpload)
+            queue.send(PowerSyncControlArguments.DidRefreshToken)
+
+            queue.bufferState.value.bufferedLines shouldBe 1
+            queue.close()
+
+            queue.receiveOrNull() shouldBe PowerSyncControlArguments.TextLine("abcd")
+            queue.receiveOrNull() shouldBe PowerSyncControlArguments.CompletedUpload
+            queue.receiveOrNull() shouldBe PowerSyncControlArguments.DidRefreshToken
+            queue.receiveOrNull() shouldBe null
+        }
+}
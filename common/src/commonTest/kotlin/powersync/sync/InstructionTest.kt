@@ -0,0 +1,98 @@
+package powersync.sync
+
+import com.powersync.sync.CoreSyncStatus
+import com.powersync.sync.Instruction
+import com.powersync.sync.coalesceStatusUpdates
+import com.powersync.sync.decodeInstructions
+import com.powersync.utils.JsonUtil
+import kotlinx.serialization.json.JsonObject
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertIs
+
+class InstructionTest {
+    @Test
+    fun coalescesStatusUpdates() {
+        val first = Instruction.UpdateSyncStatus(status(connecting = true))
+        val log = Instruction.LogLine("DEBUG", "line")
+        val second = Instruction.UpdateSyncStatus(status(connecting = false))
+
+        assertEquals(
+            listOf(log, second, Instruction.DidCompleteSync),
+            listOf(first, log, second, Instruction.DidCompleteSync).coalesceStatusUpdates(),
+        )
+        assertEquals(listOf<Instruction>(log), listOf<Instruction>(log).coalesceStatusUpdates())
+    }
+
+    @Test
+    fun decodesInstructions() {
+        val json =
+            """
+            [
+              {"LogLine": {"severity": "DEBUG", "line": "a \"quoted\" [line]"}},
+              {"UpdateSyncStatus": {"status": {"connected": true, "connecting": false, "downloading": null, "priority_status": [], "streams": []}}},
+              {"EstablishSyncStream": {"request": {"buckets": [1, 2.5, null]}}},
+              {"FetchCredentials": {"did_expire": false}},
+              {"CloseSyncStream": {"hide_disconnect": true}},
+              {"FlushFileSystem": {}},
+              {"DidCompleteSync": {}}
+            ]
+            """.trimIndent()
+
+        val expected =
+            listOf(
+                Instruction.LogLine("DEBUG", "a \"quoted\" [line]"),
+                Instruction.UpdateSyncStatus(
+                    CoreSyncStatus(
+                        connected = true,
+                        connecting = false,
+                        downloading = null,
+                        priorityStatus = emptyList(),
+                        streams = emptyList(),
+                    ),
+                ),
+                Instruction.EstablishSyncStream(JsonObject(mapOf("buckets" to JsonUtil.json.parseToJsonElement("[1, 2.5, null]")))),
+                Instruction.FetchCredentials(false),
+                Instruction.CloseSyncStream(true),
+                Instruction.FlushSileSystem,
+                Instruction.DidCompleteSync,
+            )
+
+        assertEquals(expected, decodeInstructions(json))
+        assertEquals(emptyList(), decodeInstructions(" [ ] "))
+    }
+
+    @Test
+    fun decodesSupersededStatusUpdatesLazily() {
+        // The first status is invalid, so accessing it would throw.
+        val json =
+            """
+            [{"UpdateSyncStatus": {"status": {"connected": "invalid"}}},
+             {"UpdateSyncStatus": {"status": {"connected": false, "connecting": true, "downloading": null, "priority_status": [], "streams": []}}}]
+            """.trimIndent()
+
+        val instructions = decodeInstructions(json).coalesceStatusUpdates()
+        val update = assertIs<Instruction.UpdateSyncStatus>(instructions.single())
+        assertEquals(true, update.status.connecting)
+    }
+
+    @Test
+    fun matchesSerializerForUnknownInstructions() {
+        for (json in listOf(
+            """[{"SomethingNew": 3}]""",
+            """[{"LogLine": {"severity": "DEBUG", "line": ""}, "Other": 1}]""",
+            """[{}]""",
+        )) {
+            assertEquals(JsonUtil.json.decodeFromString<List<Instruction>>(json), decodeInstructions(json))
+        }
+    }
+
+    private fun status(connecting: Boolean) =
+        CoreSyncStatus(
+            connected = false,
+            connecting = connecting,
+            downloading = null,
+            priorityStatus = emptyList(),
+            streams = emptyList(),
+        )
+}
@@ -14,6 +14,7 @@ import com.powersync.db.crud.UpdateType
 import com.powersync.db.schema.Schema
 import com.powersync.sync.StreamingSyncClient
 import com.powersync.sync.StreamingSyncClient.Companion.bsonObjects
+import com.powersync.sync.StreamingSyncClient.Companion.lineBytes
 import com.powersync.sync.SyncClientConfiguration
 import com.powersync.sync.SyncOptions
 import com.powersync.sync.configureSyncHttpClient
@@ -212,6 +213,29 @@ class StreamingSyncClientTest {
             job.cancel()
         }
 
+    @Test
+    fun splitLines() =
+        runTest {
+            turbineScope {
+                val channel = ByteChannel()
+                val lines = channel.lineBytes().testIn(this)
+
+                channel.writeByteArray("{\"a\": 1}\n{\"b\"".encodeToByteArray())
+                channel.flush()
+                lines.awaitItem().decodeToString() shouldBe "{\"a\": 1}"
+
+                channel.writeByteArray(": \"ü\"}\r\n\n".encodeToByteArray())
+                channel.flush()
+                lines.awaitItem().decodeToString() shouldBe "{\"b\": \"ü\"}"
+
+                channel.writeByteArray("{}".encodeToByteArray())
+                channel.flush()
+                channel.close()
+                lines.awaitItem().decodeToString() shouldBe "{}"
+                lines.awaitComplete()
+            }
+        }
+
     @Test
     fun splitBsonObjects() =
         runTest {
@@ -0,0 +1,77 @@
+package powersync.sync
+
+import com.powersync.bucket.StreamPriority
+import com.powersync.sync.CoreBucketProgress
+import com.powersync.sync.SyncDownloadProgress
+import com.powersync.sync.SyncStatusDataContainer
+import com.powersync.sync.coalesceProgressUpdates
+import io.kotest.matchers.shouldBe
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.flow.consumeAsFlow
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.test.advanceTimeBy
+import kotlinx.coroutines.test.runCurrent
+import kotlinx.coroutines.test.runTest
+import kotlin.test.Test
+import kotlin.time.Duration.Companion.milliseconds
+
+class SyncStatusCoalescingTest {
+    private fun downloading(downloaded: Long) =
+        SyncStatusDataContainer(
+            connected = true,
+            downloading = true,
+            downloadProgress =
+                SyncDownloadProgress(
+                    mapOf("a" to CoreBucketProgress(StreamPriority.FULL_SYNC_PRIORITY, 0, downloaded, 100)),
+                ),
+        )
+
+    @Test
+    fun coalescesProgressOnlyChanges() =
+        runTest {
+            val updates = Channel<SyncStatusDataContainer>(Channel.UNLIMITED)
+            val emitted = mutableListOf<SyncStatusDataContainer>()
+            backgroundScope.launch {
+                updates
+                    .consumeAsFlow()
+                    .coalesceProgressUpdates(100.milliseconds, testScheduler.timeSource)
+                    .collect { emitted.add(it) }
+            }
+
+            updates.send(downloading(0))
+            runCurrent()
+            emitted shouldBe listOf(downloading(0))
+
+            for (i in 1L..10L) {
+                updates.send(downloading(i))
+                advanceTimeBy(5)
+            }
+            // Intermediate progress is skipped, the latest progress is emitted after the interval.
+            emitted.size shouldBe 1
+            advanceTimeBy(100)
+            emitted shouldBe listOf(downloading(0), downloading(10))
+        }
+
+    @Test
+    fun emitsOtherChangesImmediately() =
+        runTest {
+            val updates = Channel<SyncStatusDataContainer>(Channel.UNLIMITED)
+            val emitted = mutableListOf<SyncStatusDataContainer>()
+            backgroundScope.launch {
+                updates
+                    .consumeAsFlow()
+                    .coalesceProgressUpdates(100.milliseconds, testScheduler.timeSource)
+                    .collect { emitted.add(it) }
+            }
+
+            updates.send(downloading(0))
+            updates.send(downloading(1))
+            runCurrent()
+            val disconnected = SyncStatusDataContainer(downloadError = "connection lost")
+            updates.send(disconnected)
+            runCurrent()
+
+            // The pending progress update is replaced by the error, without waiting.
+            emitted shouldBe listOf(downloading(0), disconnected)
+        }
+}
@@ -0,0 +1,86 @@
+package powersync.utils
+
+import com.powersync.utils.TimerWheel
+import io.kotest.matchers.shouldBe
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.cancel
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.test.advanceTimeBy
+import kotlinx.coroutines.test.currentTime
+import kotlinx.coroutines.test.runCurrent
+import kotlinx.coroutines.test.runTest
+import kotlin.test.Test
+import kotlin.time.Duration.Companion.milliseconds
+import kotlin.time.Duration.Companion.seconds
+
+class TimerWheelTest {
+    @Test
+    fun resumesWaitersOfTheSameTickTogether() =
+        runTest {
+            val timers = TimerWheel(backgroundScope, tickDuration = 10.milliseconds, wheelSize = 8)
+            val resumedAt = mutableListOf<Long>()
+
+            launch {
+                timers.delay(95.milliseconds)
+                resumedAt.add(currentTime)
+            }
+            advanceTimeBy(3)
+            launch {
+                timers.delay(100.milliseconds)
+                resumedAt.add(currentTime)
+            }
+            advanceTimeBy(500)
+
+            // Both delays are rounded up to the same tick, even though the wheel rotated before
+            // they expired.
+            resumedAt shouldBe listOf(100L, 100L)
+        }
+
+    @Test
+    fun removesCancelledWaiters() =
+        runTest {
+            val timers = TimerWheel(backgroundScope, tickDuration = 10.milliseconds)
+            var resumed = false
+
+            val job =
+                launch {
+                    timers.delay(50.milliseconds)
+                    resumed = true
+                }
+            runCurrent()
+            job.cancel()
+            advanceTimeBy(100)
+
+            resumed shouldBe false
+        }
+
+    @Test
+    fun doesNotSuspendForEmptyDurations() =
+        runTest {
+            val timers = TimerWheel(backgroundScope)
+            timers.delay((-5).milliseconds)
+            currentTime shouldBe 0L
+        }
+
+    @Test
+    fun resumesWaitersWhenScopeIsCancelled() =
+        runTest {
+            val scope = CoroutineScope(backgroundScope.coroutineContext + Job(backgroundScope.coroutineContext[Job]))
+            val timers = TimerWheel(scope, tickDuration = 10.milliseconds)
+            var resumed = false
+
+            launch {
+                timers.delay(1.seconds)
+                resumed = true
+            }
+            runCurrent()
+            scope.cancel()
+            runCurrent()
+            resumed shouldBe true
+
+            // Later delays don't wait for a ticker that can't run anymore.
+            timers.delay(50.milliseconds)
+            currentTime shouldBe 50L
+        }
+}
@@ -0,0 +1,67 @@
+package com.powersync.attachments
+
+import com.powersync.attachments.implementation.reconcileWatchedAttachments
+import com.powersync.test.writeBenchmarkReport
+import io.kotest.matchers.shouldBe
+import kotlinx.coroutines.runBlocking
+import kotlin.test.Test
+import kotlin.time.measureTimedValue
+
+/**
+ * Measures reconciling watched attachment items against the attachment queue, which happens on
+ * every emission of the watched attachments query.
+ *
+ * The queue is populated with synced attachments. The watched items drop every tenth attachment
+ * and add the same amount of new ones, so that both the archive and the download paths are taken.
+ * Runs with the `jvmBenchmark` task.
+ */
+class AttachmentReconciliationBenchmark {
+    @Test
+    fun reconcileLargeQueues() =
+        runBlocking {
+            // Warm up so that JIT compilation isn't attributed to the first measurement.
+            repeat(3) { reconcile(SIZES.first()) }
+
+            val results =
+                SIZES.associate { size ->
+                    val (updates, duration) = measureTimedValue { reconcile(size) }
+
+                    val changed = size / 10
+                    updates.count { it.state == AttachmentState.ARCHIVED } shouldBe changed
+                    updates.count { it.state == AttachmentState.QUEUED_DOWNLOAD } shouldBe changed
+
+                    "$size attachments (ms)" to duration.inWholeMilliseconds
+                }
+
+            writeBenchmarkReport("AttachmentReconciliationBenchmark", results)
+        }
+
+    private suspend fun reconcile(size: Int): List<Attachment> {
+        val current =
+            List(size) { i ->
+                Attachment(
+                    id = "attachment-$i",
+                    filename = "attachment-$i.jpg",
+                    state = AttachmentState.SYNCED,
+                    localUri = "attachments/attachment-$i.jpg",
+                    hasSynced = true,
+                )
+            }
+        val items =
+            List(size) { i ->
+                val id = if (i % 10 == 0) "new-attachment-$i" else "attachment-$i"
+                WatchedAttachmentItem(id = id, fileExtension = "jpg")
+            }
+
+        return reconcileWatchedAttachments(
+            current = current,
+            items = items,
+            downloadAttachments = true,
+            resolveFilename = { id, extension -> "$id.$extension" },
+        )
+    }
+
+    private companion object {
+        val SIZES = listOf(10_000, 50_000, 100_000)
+    }
+}
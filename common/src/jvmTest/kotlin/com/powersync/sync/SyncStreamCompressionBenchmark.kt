@@ -0,0 +1,134 @@
+package com.powersync.sync
+
+import com.powersync.ExperimentalPowerSyncAPI
+import com.powersync.sync.StreamingSyncClient.Companion.lineBytes
+import com.powersync.test.writeBenchmarkReport
+import io.kotest.matchers.comparables.shouldBeLessThan
+import io.kotest.matchers.shouldBe
+import io.ktor.client.HttpClient
+import io.ktor.client.engine.mock.MockEngine
+import io.ktor.client.engine.mock.respond
+import io.ktor.client.request.preparePost
+import io.ktor.client.statement.bodyAsChannel
+import io.ktor.http.HttpHeaders
+import io.ktor.http.HttpStatusCode
+import io.ktor.http.headersOf
+import io.ktor.utils.io.ByteReadChannel
+import kotlinx.coroutines.runBlocking
+import java.io.ByteArrayOutputStream
+import java.lang.management.ManagementFactory
+import java.util.zip.GZIPOutputStream
+import kotlin.test.Test
+
+/**
+ * Compares bytes received and CPU time for uncompressed and gzip-compressed sync streams.
+ *
+ * The sync service is replaced with a [MockEngine] serving a pre-encoded NDJSON stream, compressed
+ * only if the client asks for it through its `Accept-Encoding` header. This measures decompression
+ * and line splitting in isolation from the database. Runs with the `jvmBenchmark` task.
+ */
+@OptIn(ExperimentalPowerSyncAPI::class)
+class SyncStreamCompressionBenchmark {
+    private val plain = syntheticSyncStream(lines = LINES)
+    private val gzipped =
+        ByteArrayOutputStream()
+            .also { out ->
+                GZIPOutputStream(out).use { it.write(plain) }
+            }.toByteArray()
+
+    @Test
+    fun compareCompressedStream() =
+        runBlocking {
+            // Warm up both paths so that JIT compilation isn't attributed to either measurement.
+            repeat(3) {
+                readStream(compressResponses = false)
+                readStream(compressResponses = true)
+            }
+
+            val uncompressed = readStream(compressResponses = false)
+            val compressed = readStream(compressResponses = true)
+
+            uncompressed.lines shouldBe LINES
+            compressed.lines shouldBe LINES
+            compressed.decodedBytes shouldBe uncompressed.decodedBytes
+            uncompressed.receivedBytes shouldBe plain.size.toLong()
+            compressed.receivedBytes shouldBeLessThan uncompressed.receivedBytes
+
+            writeBenchmarkReport(
+                "SyncStreamCompressionBenchmark",
+                mapOf(
+                    "lines" to LINES,
+                    "uncompressed bytes received" to uncompressed.receivedBytes,
+                    "uncompressed CPU ms" to uncompressed.cpuMillis,
+                    "gzip bytes received" to compressed.receivedBytes,
+                    "gzip CPU ms" to compressed.cpuMillis,
+                ),
+            )
+        }
+
+    private suspend fun readStream(compressResponses: Boolean): StreamResult {
+        var receivedBytes = 0L
+        val engine =
+            MockEngine { request ->
+                val acceptsGzip = request.headers[HttpHeaders.AcceptEncoding]?.contains("gzip") == true
+                val (body, headers) =
+                    if (acceptsGzip) {
+                        gzipped to headersOf(HttpHeaders.ContentEncoding, "gzip")
+                    } else {
+                        plain to headersOf()
+                    }
+
+                receivedBytes += body.size
+                respond(ByteReadChannel(body), HttpStatusCode.OK, headers)
+            }
+        val client =
+            HttpClient(engine) {
+                configureSyncHttpClient(compressResponses = compressResponses)
+            }
+
+        val cpuBefore = processCpuTime()
+        var lines = 0
+        var decodedBytes = 0L
+        client.preparePost("http://localhost/sync/stream").execute { response ->
+            response.bodyAsChannel().lineBytes().collect {
+                lines++
+                decodedBytes += it.size
+            }
+        }
+        val cpuNanos = processCpuTime() - cpuBefore
+        client.close()
+
+        return StreamResult(lines, decodedBytes, receivedBytes, cpuNanos / 1_000_000)
+    }
+
+    private fun processCpuTime(): Long {
+        val bean = ManagementFactory.getOperatingSystemMXBean() as com.sun.management.OperatingSystemMXBean
+        return bean.processCpuTime
+    }
+
+    private fun syntheticSyncStream(lines: Int): ByteArray {
+        val builder = StringBuilder()
+        repeat(lines) { i ->
+            // Resembles an oplog entry in a data line, which is what initial syncs mostly consist of.
+            builder.append(
+                """{"data":{"bucket":"todos[\"user\"]","after":"${i - 1}","next_after":"$i","data":[""" +
+                    """{"op_id":"$i","op":"PUT","object_type":"todos","object_id":"todo-$i","checksum":${i * 31},""" +
+                    """"data":"{\"description\":\"Todo item number $i\",\"completed\":${i % 2 == 0},""" +
+                    """\"list_id\":\"list-${i % 10}\"}"}]}}""",
+            )
+            builder.append('\n')
+        }
+        return builder.toString().encodeToByteArray()
+    }
+
+    private class StreamResult(
+        val lines: Int,
+        val decodedBytes: Long,
+        val receivedBytes: Long,
+        val cpuMillis: Long,
+    )
+
+    private companion object {
+        const val LINES = 20_000
+    }
+}
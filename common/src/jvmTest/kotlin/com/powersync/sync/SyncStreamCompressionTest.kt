@@ -0,0 +1,84 @@
+package com.powersync.sync
+
+import com.powersync.ExperimentalPowerSyncAPI
+import com.powersync.internal.InternalPowerSyncAPI
+import com.powersync.internal.httpClientIsKnownToDecompressResponses
+import com.powersync.sync.StreamingSyncClient.Companion.lineBytes
+import io.kotest.matchers.shouldBe
+import io.ktor.client.HttpClient
+import io.ktor.client.engine.HttpClientEngineConfig
+import io.ktor.client.engine.mock.MockEngine
+import io.ktor.client.engine.mock.MockEngineConfig
+import io.ktor.client.engine.mock.respond
+import io.ktor.client.request.preparePost
+import io.ktor.client.statement.bodyAsChannel
+import io.ktor.http.HttpHeaders
+import io.ktor.http.HttpStatusCode
+import io.ktor.http.headersOf
+import io.ktor.utils.io.ByteReadChannel
+import kotlinx.coroutines.flow.map
+import kotlinx.coroutines.flow.toList
+import kotlinx.coroutines.test.runTest
+import java.io.ByteArrayOutputStream
+import java.util.zip.GZIPOutputStream
+import kotlin.concurrent.atomics.ExperimentalAtomicApi
+import kotlin.test.Test
+
+@OptIn(ExperimentalPowerSyncAPI::class)
+class SyncStreamCompressionTest {
+    private val lines = listOf("""{"checkpoint":{"last_op_id":"1","buckets":[]}}""", """{"checkpoint_complete":{"last_op_id":"1"}}""")
+    private val plain = lines.joinToString(separator = "\n", postfix = "\n").encodeToByteArray()
+
+    @Test
+    fun decodesGzipStream() =
+        runTest {
+            val gzipped =
+                ByteArrayOutputStream()
+                    .also { out ->
+                        GZIPOutputStream(out).use { it.write(plain) }
+                    }.toByteArray()
+
+            var acceptEncoding: String? = null
+            val engine =
+                MockEngine { request ->
+                    acceptEncoding = request.headers[HttpHeaders.AcceptEncoding]
+                    respond(ByteReadChannel(gzipped), HttpStatusCode.OK, headersOf(HttpHeaders.ContentEncoding, "gzip"))
+                }
+
+            readLines(engine) shouldBe lines
+            acceptEncoding?.contains("gzip") shouldBe true
+        }
+
+    @OptIn(ExperimentalAtomicApi::class, InternalPowerSyncAPI::class)
+    @Test
+    fun doesNotDecompressTwiceOnEnginesDecompressingResponses() =
+        runTest {
+            // Engines like Darwin decompress responses by themselves, but keep the header.
+            val check: (HttpClientEngineConfig) -> Boolean = { it is MockEngineConfig }
+            httpClientIsKnownToDecompressResponses.compareAndSet(null, check) shouldBe true
+
+            try {
+                val engine =
+                    MockEngine {
+                        respond(ByteReadChannel(plain), HttpStatusCode.OK, headersOf(HttpHeaders.ContentEncoding, "gzip"))
+                    }
+
+                readLines(engine) shouldBe lines
+            } finally {
+                httpClientIsKnownToDecompressResponses.compareAndSet(check, null)
+            }
+        }
+
+    private suspend fun readLines(engine: MockEngine): List<String> {
+        val client =
+            HttpClient(engine) {
+                configureSyncHttpClient(compressResponses = true)
+            }
+
+        return client
+            .preparePost("http://localhost/sync/stream")
+            .execute { response ->
+                response.bodyAsChannel().lineBytes().map { it.decodeToString() }.toList()
+            }.also { client.close() }
+    }
+}
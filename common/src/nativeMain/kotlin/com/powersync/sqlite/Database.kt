@@ -3,8 +3,12 @@ package com.powersync.sqlite
 import androidx.sqlite.SQLiteConnection
 import androidx.sqlite.SQLiteStatement
 import cnames.structs.sqlite3
+import cnames.structs.sqlite3_session
 import cnames.structs.sqlite3_stmt
+import com.powersync.ExperimentalPowerSyncAPI
 import com.powersync.PowerSyncException
+import com.powersync.db.driver.ChangesetSession
+import com.powersync.db.driver.SessionRecordingConnection
 import com.powersync.internal.sqlite3.sqlite3_auto_extension
 import com.powersync.internal.sqlite3.sqlite3_close_v2
 import com.powersync.internal.sqlite3.sqlite3_db_config
@@ -14,6 +18,7 @@ import com.powersync.internal.sqlite3.sqlite3_get_autocommit
 import com.powersync.internal.sqlite3.sqlite3_initialize
 import com.powersync.internal.sqlite3.sqlite3_open_v2
 import com.powersync.internal.sqlite3.sqlite3_prepare16_v3
+import com.powersync.internal.sqlite3.sqlite3session_create
 import kotlinx.cinterop.ByteVar
 import kotlinx.cinterop.CPointer
 import kotlinx.cinterop.CPointerVar
@@ -34,9 +39,10 @@ import kotlinx.cinterop.value
  * [com.powersync.db.driver.InternalConnectionPool] and called from [kotlinx.coroutines.Dispatchers.IO]
  * to make these APIs asynchronous.
  */
+@OptIn(ExperimentalPowerSyncAPI::class)
 public class Database(
     private val ptr: CPointer<sqlite3>,
-) : SQLiteConnection {
+) : SessionRecordingConnection {
     override fun inTransaction(): Boolean {
         // We're in a transaction if autocommit is disabled
         return sqlite3_get_autocommit(ptr) == 0
@@ -52,6 +58,14 @@ public class Database(
             Statement(sql, ptr, stmtPtr.value!!)
         }
 
+    override fun openChangesetSession(): ChangesetSession =
+        memScoped {
+            val sessionPtr = allocPointerTo<sqlite3_session>()
+            sqlite3session_create(ptr, "main".cstr.getPointer(this), sessionPtr.ptr).checkResult()
+
+            Session(ptr, sessionPtr.value!!)
+        }
+
     override fun close() {
         sqlite3_close_v2(ptr)
     }
@@ -0,0 +1,63 @@
+package com.powersync.sqlite
+
+import cnames.structs.sqlite3
+import cnames.structs.sqlite3_session
+import com.powersync.ExperimentalPowerSyncAPI
+import com.powersync.db.driver.ChangesetSession
+import com.powersync.internal.sqlite3.sqlite3_free
+import com.powersync.internal.sqlite3.sqlite3session_attach
+import com.powersync.internal.sqlite3.sqlite3session_changeset
+import com.powersync.internal.sqlite3.sqlite3session_delete
+import kotlinx.cinterop.ByteVar
+import kotlinx.cinterop.COpaquePointerVar
+import kotlinx.cinterop.CPointer
+import kotlinx.cinterop.IntVar
+import kotlinx.cinterop.alloc
+import kotlinx.cinterop.memScoped
+import kotlinx.cinterop.ptr
+import kotlinx.cinterop.readBytes
+import kotlinx.cinterop.reinterpret
+import kotlinx.cinterop.value
+
+/**
+ * A [ChangesetSession] backed by a `sqlite3_session` pointer attached to all tables.
+ */
+@OptIn(ExperimentalPowerSyncAPI::class)
+internal class Session(
+    private val db: CPointer<sqlite3>,
+    private val ptr: CPointer<sqlite3_session>,
+) : ChangesetSession {
+    init {
+        val rc = sqlite3session_attach(ptr, null)
+        if (rc != 0) {
+            sqlite3session_delete(ptr)
+            throw createExceptionInDatabase(db)
+        }
+    }
+
+    override fun changeset(): ByteArray? =
+        memScoped {
+            val size = alloc<IntVar>()
+            val buffer = alloc<COpaquePointerVar>()
+
+            val rc = sqlite3session_changeset(ptr, size.ptr, buffer.ptr)
+            if (rc != 0) {
+                throw createExceptionInDatabase(db)
+            }
+
+            val data = buffer.value ?: return@memScoped null
+            try {
+                if (size.value == 0) {
+                    null
+                } else {
+                    data.reinterpret<ByteVar>().readBytes(size.value)
+                }
+            } finally {
+                sqlite3_free(data)
+            }
+        }
+
+    override fun close() {
+        sqlite3session_delete(ptr)
+    }
+}
@@ -2,7 +2,10 @@ package com.powersync.sqlite
 
 import androidx.sqlite.SQLiteConnection
 import androidx.sqlite.execSQL
+import com.powersync.ExperimentalPowerSyncAPI
 import com.powersync.PowerSyncException
+import com.powersync.db.RowChange
+import com.powersync.db.RowChangeset
 import io.kotest.assertions.throwables.shouldThrow
 import io.kotest.matchers.shouldBe
 import kotlin.test.Test
@@ -29,6 +32,26 @@ class DatabaseTest {
             Unit
         }
 
+    @Test
+    @OptIn(ExperimentalPowerSyncAPI::class)
+    fun recordsChangesets() =
+        Database.open(":memory:", 2).use {
+            it.execSQL("CREATE TABLE users (id TEXT PRIMARY KEY, name TEXT)")
+
+            it.openChangesetSession().use { session ->
+                session.changeset() shouldBe null
+
+                it.execSQL("INSERT INTO users (id, name) VALUES ('a', 'first')")
+                val changes = RowChangeset(session.changeset()!!).changes()
+                changes.size shouldBe 1
+                changes[0].operation shouldBe RowChange.Operation.INSERT
+                changes[0].primaryKey shouldBe listOf("a")
+                changes[0].newValues shouldBe mapOf(0 to "a", 1 to "first")
+            }
+
+            Unit
+        }
+
     private companion object {
         private fun inMemoryDatabase(): SQLiteConnection = Database.open(":memory:", 2)
     }
@@ -2,6 +2,7 @@ package com.powersync
 
 import com.powersync.db.NativeConnectionFactory
 import com.powersync.internal.InternalPowerSyncAPI
+import com.powersync.internal.httpClientIsKnownToDecompressResponses
 import com.powersync.internal.httpClientIsKnownToNotSupportBackpressure
 import io.ktor.client.engine.HttpClientEngineConfig
 import io.ktor.client.engine.darwin.DarwinClientEngineConfig
@@ -13,6 +14,7 @@ public actual class DatabaseDriverFactory : NativeConnectionFactory() {
     init {
         // Hack: Install apple-specific httpClientIsKnownToNotSupportBackpressure hook.
         httpClientIsKnownToNotSupportBackpressure.compareAndSet(null, ::appleClientKnownNotSupportBackpressure)
+        httpClientIsKnownToDecompressResponses.compareAndSet(null, ::appleClientDecompressesResponses)
     }
 
     actual override fun resolveDefaultDatabasePath(dbFilename: String): String = appleDefaultDatabasePath(dbFilename)
@@ -20,4 +22,7 @@ public actual class DatabaseDriverFactory : NativeConnectionFactory() {
 
 private fun appleClientKnownNotSupportBackpressure(config: HttpClientEngineConfig): Boolean = config is DarwinClientEngineConfig
 
+// NSURLSession negotiates compression and decompresses responses by itself.
+private fun appleClientDecompressesResponses(config: HttpClientEngineConfig): Boolean = config is DarwinClientEngineConfig
+
 internal actual val inMemoryDriver: InMemoryConnectionFactory = DatabaseDriverFactory()
@@ -1,5 +1,7 @@
 package com.powersync.integrations.room
 
+import androidx.room.execSQL
+import androidx.room.immediateTransaction
 import androidx.sqlite.driver.bundled.BundledSQLiteDriver
 import app.cash.turbine.turbineScope
 import co.touchlab.kermit.CommonWriter
@@ -10,10 +12,14 @@ import com.powersync.PowerSyncDatabase
 import com.powersync.db.getString
 import io.kotest.matchers.collections.shouldHaveSize
 import io.kotest.matchers.shouldBe
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.launch
 import kotlinx.coroutines.test.runTest
 import kotlin.test.AfterTest
 import kotlin.test.BeforeTest
 import kotlin.test.Test
+import kotlin.time.Duration.Companion.milliseconds
 
 class PowerSyncRoomTest {
     lateinit var database: TestDatabase
@@ -93,6 +99,121 @@ class PowerSyncRoomTest {
             powersync.close()
         }
 
+    @Test
+    fun roomWriterConnectionForwardsUpdatesOnce() =
+        runTest {
+            // Without a schema, updates are only transferred by useWriterConnection.
+            val pool = RoomConnectionPool(database)
+
+            val powersync =
+                PowerSyncDatabase.opened(
+                    pool = pool,
+                    scope = this,
+                    schema = TestDatabase.schema,
+                    identifier = "test",
+                    logger = logger,
+                )
+
+            // Wait for the database to be initialized, so that we only see our own updates.
+            powersync.readLock { }
+
+            turbineScope {
+                val updates = pool.updates.testIn(this)
+
+                pool.useWriterConnection { transactor ->
+                    transactor.immediateTransaction {
+                        repeat(10) {
+                            execSQL("INSERT INTO user (id, name) VALUES (uuid(), 'Room user')")
+                        }
+                    }
+
+                    // PowerSync writes share the lease.
+                    powersync.execute("insert into user values (uuid(), ?)", listOf("PowerSync user"))
+                }
+
+                updates.awaitItem() shouldBe setOf("user")
+                updates.expectNoEvents()
+                updates.cancel()
+            }
+
+            powersync.getAll("SELECT * FROM user") { it.getString("name") } shouldHaveSize 11
+            powersync.close()
+        }
+
+    @Test
+    fun roomWriterConnectionSerializesConcurrentWrites() =
+        runTest {
+            val pool = RoomConnectionPool(database)
+
+            val powersync =
+                PowerSyncDatabase.opened(
+                    pool = pool,
+                    scope = this,
+                    schema = TestDatabase.schema,
+                    identifier = "test",
+                    logger = logger,
+                )
+            powersync.readLock { }
+
+            turbineScope {
+                val updates = pool.updates.testIn(this)
+
+                pool.useWriterConnection {
+                    // Coroutines launched here inherit the lease, their transactions must not overlap
+                    // with each other or with those of the coroutine owning the lease.
+                    coroutineScope {
+                        repeat(10) {
+                            launch(Dispatchers.Default) {
+                                powersync.writeTransaction { tx ->
+                                    tx.execute("insert into user values (uuid(), ?)", listOf("PowerSync user"))
+                                    tx.execute("insert into user values (uuid(), ?)", listOf("PowerSync user"))
+                                }
+                            }
+                        }
+
+                        powersync.writeTransaction { tx ->
+                            tx.execute("insert into user values (uuid(), ?)", listOf("PowerSync user"))
+                            tx.execute("insert into user values (uuid(), ?)", listOf("PowerSync user"))
+                        }
+                    }
+                }
+
+                updates.awaitItem() shouldBe setOf("user")
+                updates.expectNoEvents()
+                updates.cancel()
+            }
+
+            powersync.getAll("SELECT * FROM user") { it.getString("name") } shouldHaveSize 22
+            powersync.close()
+        }
+
+    @Test
+    fun roomWriterConnectionWithGroupCommit() =
+        runTest {
+            val pool = RoomConnectionPool(database)
+
+            val powersync =
+                PowerSyncDatabase.opened(
+                    pool = pool,
+                    scope = this,
+                    schema = TestDatabase.schema,
+                    identifier = "test",
+                    logger = logger,
+                    groupCommitWindow = 10.milliseconds,
+                )
+            powersync.readLock { }
+
+            // Batches can't wait for the writer held here, so this must not be batched.
+            pool.useWriterConnection {
+                powersync.execute("insert into user values (uuid(), ?)", listOf("PowerSync user"))
+            }
+            // Outside of useWriterConnection, statements are batched again.
+            powersync.execute("insert into user values (uuid(), ?)", listOf("PowerSync user"))
+
+            powersync.getAll("SELECT * FROM user") { it.getString("name") } shouldHaveSize 2
+            powersync.close()
+        }
+
     @Test
     fun powersyncWriteRoomRead() =
         runTest {
@@ -7,15 +7,22 @@ import androidx.room.useReaderConnection
 import androidx.room.useWriterConnection
 import androidx.sqlite.SQLiteException
 import androidx.sqlite.SQLiteStatement
+import com.powersync.ExperimentalPowerSyncAPI
+import com.powersync.db.driver.ReentrantWritePool
 import com.powersync.db.driver.SQLiteConnectionLease
 import com.powersync.db.driver.SQLiteConnectionPool
 import com.powersync.db.schema.Schema
 import kotlinx.coroutines.currentCoroutineContext
 import kotlinx.coroutines.flow.MutableSharedFlow
 import kotlinx.coroutines.flow.SharedFlow
+import kotlinx.coroutines.flow.conflate
 import kotlinx.coroutines.launch
 import kotlinx.coroutines.runBlocking
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlinx.coroutines.withContext
 import kotlinx.serialization.json.Json
+import kotlin.coroutines.AbstractCoroutineContextElement
 import kotlin.coroutines.CoroutineContext
 
 /**
@@ -30,12 +37,15 @@ import kotlin.coroutines.CoroutineContext
  * On the other hand, the PowerSync SDK needs to be notified about updates in Room. For that, a
  * schema parameter can be used in the constructor. It will call [syncRoomUpdatesToPowerSync] to
  * collect a Room flow on all tables. Alternatively, [transferPendingRoomUpdatesToPowerSync] can be
- * called after issuing writes in Room to transfer them to PowerSync.
+ * called after issuing writes in Room to transfer them to PowerSync. Writes issued through
+ * [useWriterConnection] are transferred to PowerSync directly.
  */
+@OptIn(ExperimentalPowerSyncAPI::class)
 public class RoomConnectionPool(
     private val db: RoomDatabase,
     schema: Schema? = null,
-) : SQLiteConnectionPool {
+) : SQLiteConnectionPool,
+    ReentrantWritePool {
     private val _updates = MutableSharedFlow<Set<String>>()
     private var hasInstalledUpdateHook = false
 
@@ -56,9 +66,25 @@ public class RoomConnectionPool(
             callback(RoomTransactionLease(it, currentCoroutineContext()))
         }
 
+    /**
+     * Runs [block] on Room's writer connection and transfers updates made in it to PowerSync once
+     * it completes.
+     *
+     * Unlike writes made on the Room database directly, this doesn't wait for Room's invalidation
+     * tracker and doesn't lease the writer connection a second time to transfer updates. Writes made
+     * by the PowerSync database while [block] is running share the connection, and all tables
+     * updated in [block] are forwarded to PowerSync as a single update. Writes from coroutines
+     * launched in [block] run one at a time, but [block] shouldn't
+     * use the [Transactor] itself while they're running.
+     */
+    public suspend fun <R> useWriterConnection(block: suspend (Transactor) -> R): R = useWriter(block)
+
     /**
      * Makes pending updates tracked by Room's invalidation tracker available to the PowerSync
      * database, updating flows and triggering CRUD uploads.
+     *
+     * When called inside [useWriterConnection], updates are transferred once the outermost
+     * [useWriterConnection] call completes.
      */
     public suspend fun transferPendingRoomUpdatesToPowerSync() {
         write {
@@ -73,7 +99,9 @@ public class RoomConnectionPool(
     public fun syncRoomUpdatesToPowerSync(schema: Schema) {
         db.getCoroutineScope().launch {
             val tables = schema.rawTables.map { it.name }.toTypedArray()
-            db.invalidationTracker.createFlow(*tables, emitInitialState = false).collect {
+            // Pending updates accumulate on the connection until they're transferred, so a single
+            // transfer after a burst of Room transactions forwards all of them together.
+            db.invalidationTracker.createFlow(*tables, emitInitialState = false).conflate().collect {
                 try {
                     transferPendingRoomUpdatesToPowerSync()
                 } catch (e: SQLiteException) {
@@ -91,54 +119,97 @@ public class RoomConnectionPool(
     }
 
     override suspend fun <T> write(callback: suspend (SQLiteConnectionLease) -> T): T =
-        db.useWriterConnection {
+        useWriter {
+            callback(RoomTransactionLease(it, currentCoroutineContext()))
+        }
+
+    private suspend fun <T> useWriter(block: suspend (Transactor) -> T): T {
+        // Nested writes share the outer lease, which forwards all updates once it completes.
+        // Coroutines launched inside a write inherit the lease and may run concurrently with the
+        // coroutine owning it, so every nested use of the lease is serialized, including the owner's.
+        currentCoroutineContext()[ActiveWrite]?.takeIf { it.pool === this }?.let { active ->
+            return active.nestedWrites.withLock {
+                active.transactor.runWithLease(block)
+            }
+        }
+
+        return db.useWriterConnection {
             if (!hasInstalledUpdateHook) {
                 hasInstalledUpdateHook = true
                 it.execSQL("SELECT powersync_update_hooks('install')")
             }
 
             try {
-                callback(RoomTransactionLease(it, currentCoroutineContext()))
+                it.runWithLease(block)
             } finally {
-                // List changed tables, excluding virtual and shadow tables for e.g. fts5
-                val statement =
-                    """
-                    SELECT
-                        value,
-                        (SELECT type FROM pragma_table_list(value))
-                    FROM json_each(powersync_update_hooks('get'))
-                    """.trimIndent()
-
-                val allChangedTables = mutableSetOf<String>()
-                val changedRoomTables = mutableListOf<String>()
-
-                it.usePrepared(statement) { stmt ->
-                    while (stmt.step()) {
-                        val table = stmt.getText(0)
-                        val type = if (stmt.isNull(1)) null else stmt.getText(1)
-                        allChangedTables.add(table)
-                        if (type == "table" && !table.startsWith("ps_") && !table.startsWith("room_")) {
-                            changedRoomTables.add(table)
-                        }
-                    }
-                }
+                forwardPendingUpdates(it)
+            }
+        }
+    }
 
-                if (changedRoomTables.isNotEmpty()) {
-                    db.invalidationTracker.refresh(*changedRoomTables.toTypedArray())
-                }
+    private suspend fun <T> Transactor.runWithLease(block: suspend (Transactor) -> T): T =
+        withContext(ActiveWrite(this@RoomConnectionPool, this)) {
+            block(this@runWithLease)
+        }
 
-                _updates.emit(allChangedTables)
+    private suspend fun forwardPendingUpdates(transactor: Transactor) {
+        // List changed tables, excluding virtual and shadow tables for e.g. fts5
+        val statement =
+            """
+            SELECT
+                value,
+                (SELECT type FROM pragma_table_list(value))
+            FROM json_each(powersync_update_hooks('get'))
+            """.trimIndent()
+
+        val allChangedTables = mutableSetOf<String>()
+        val changedRoomTables = mutableListOf<String>()
+
+        transactor.usePrepared(statement) { stmt ->
+            while (stmt.step()) {
+                val table = stmt.getText(0)
+                val type = if (stmt.isNull(1)) null else stmt.getText(1)
+                allChangedTables.add(table)
+                if (type == "table" && !table.startsWith("ps_") && !table.startsWith("room_")) {
+                    changedRoomTables.add(table)
+                }
             }
         }
 
+        if (changedRoomTables.isNotEmpty()) {
+            db.invalidationTracker.refresh(*changedRoomTables.toTypedArray())
+        }
+
+        if (allChangedTables.isNotEmpty()) {
+            _updates.emit(allChangedTables)
+        }
+    }
+
     override val updates: SharedFlow<Set<String>>
         get() = _updates
 
+    override suspend fun isInWrite(): Boolean = currentCoroutineContext()[ActiveWrite]?.pool === this
+
     override suspend fun close() {
         // Noop, Room database managed independently
     }
 }
 
+/**
+ * Marks coroutines running inside a write lease of [pool], so that nested writes can reuse it.
+ *
+ * Nested writes lock [nestedWrites] before using the lease, since coroutines inheriting this
+ * element may run concurrently.
+ */
+private class ActiveWrite(
+    val pool: RoomConnectionPool,
+    val transactor: Transactor,
+) : AbstractCoroutineContextElement(ActiveWrite) {
+    val nestedWrites = Mutex()
+
+    companion object Key : CoroutineContext.Key<ActiveWrite>
+}
+
 private class RoomTransactionLease(
     private val transactor: Transactor,
     /**
@@ -1,3 +1,4 @@
+import com.powersync.plugins.utils.jvmBenchmarks
 import com.powersync.plugins.utils.powersyncTargets
 
 plugins {
@@ -51,6 +52,9 @@ kotlin {
     }
 }
 
+// Benchmarks in jvmTest only run with ./gradlew :integrations:sqldelight:jvmBenchmark
+jvmBenchmarks()
+
 dokka {
     moduleName.set("PowerSync for SQLDelight")
 }
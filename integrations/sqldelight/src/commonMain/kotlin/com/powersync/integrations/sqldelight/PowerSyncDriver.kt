@@ -34,6 +34,11 @@ import kotlinx.coroutines.launch
 public class PowerSyncDriver(
     private val db: PowerSyncDatabase,
     private val scope: CoroutineScope,
+    /**
+     * Whether statements generated by SQLDelight should stay prepared on the connection they've
+     * been used on, so that running the same query again doesn't have to compile it again.
+     */
+    private val cacheStatements: Boolean = true,
 ) : SynchronizedObject(),
     SqlDriver {
     private var transaction: PowerSyncTransaction? = null
@@ -47,6 +52,21 @@ public class PowerSyncDriver(
         return db.useConnection(readOnly = false) { body(it) }
     }
 
+    /**
+     * Runs [block] with a statement for [sql], using a statement cached on the connection if a
+     * [key] (like the identifier SQLDelight generates for each query) is available.
+     */
+    private suspend fun <R> SQLiteConnectionLease.usePrepared(
+        key: Any?,
+        sql: String,
+        block: (SQLiteStatement) -> R,
+    ): R =
+        if (cacheStatements && key != null) {
+            usePreparedCached(key, sql, block)
+        } else {
+            usePrepared(sql, block)
+        }
+
     override fun <R> executeQuery(
         identifier: Int?,
         sql: String,
@@ -60,7 +80,7 @@ public class PowerSyncDriver(
             // So, always using the write connection is a safe default. In the future we may want to
             // analyze the statement to potentially route it to a read connection if possible.
             withConnection { connection ->
-                connection.usePrepared(sql) { stmt ->
+                connection.usePrepared(identifier, sql) { stmt ->
                     val wrapper = StatementWrapper(stmt)
                     binders?.let { it(wrapper) }
 
@@ -77,7 +97,7 @@ public class PowerSyncDriver(
     ): QueryResult<Long> =
         QueryResult.AsyncValue {
             withConnection { connection ->
-                connection.usePrepared(sql) { stmt ->
+                connection.usePrepared(identifier, sql) { stmt ->
                     val wrapper = StatementWrapper(stmt)
                     binders?.let { it(wrapper) }
 
@@ -86,7 +106,7 @@ public class PowerSyncDriver(
                     }
                 }
 
-                connection.usePrepared("SELECT changes()") {
+                connection.usePrepared(ChangesKey, "SELECT changes()") {
                     check(it.step())
                     it.getLong(0)
                 }
@@ -157,6 +177,10 @@ public class PowerSyncDriver(
     }
 
     override fun close() {}
+
+    // Cache key for the statement reading the amount of changed rows, distinct from identifiers
+    // generated by SQLDelight.
+    private object ChangesKey
 }
 
 @OptIn(ExperimentalPowerSyncAPI::class)
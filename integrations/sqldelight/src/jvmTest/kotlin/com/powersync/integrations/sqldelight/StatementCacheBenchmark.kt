@@ -0,0 +1,74 @@
+package com.powersync.integrations.sqldelight
+
+import app.cash.sqldelight.async.coroutines.awaitAsList
+import com.powersync.PowerSyncDatabase
+import com.powersync.db.schema.Column
+import com.powersync.db.schema.Schema
+import com.powersync.db.schema.Table
+import com.powersync.inMemory
+import com.powersync.test.writeBenchmarkReport
+import io.kotest.matchers.shouldBe
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.runBlocking
+import kotlin.test.Test
+import kotlin.time.Duration
+import kotlin.time.measureTime
+
+/**
+ * Compares running the queries of the test database with and without statements cached by
+ * [PowerSyncDriver].
+ *
+ * Each round inserts rows one by one (outside of a transaction, so that every insert leases the
+ * connection again) and then repeatedly queries all rows. Runs with the `jvmBenchmark` task.
+ */
+class StatementCacheBenchmark {
+    @Test
+    fun repeatedQueries() =
+        runBlocking {
+            // Warm up so that JIT compilation isn't attributed to the first measurement.
+            repeat(3) {
+                measureQueries(cacheStatements = false)
+                measureQueries(cacheStatements = true)
+            }
+
+            val uncached = measureQueries(cacheStatements = false)
+            val cached = measureQueries(cacheStatements = true)
+            writeBenchmarkReport(
+                "StatementCacheBenchmark",
+                mapOf(
+                    "without statement cache (ms)" to uncached.inWholeMilliseconds,
+                    "with statement cache (ms)" to cached.inWholeMilliseconds,
+                ),
+            )
+        }
+
+    private suspend fun CoroutineScope.measureQueries(cacheStatements: Boolean): Duration {
+        val powersync = PowerSyncDatabase.inMemory(scope = this, schema = schema)
+        val db = TestDatabase(PowerSyncDriver(powersync, this, cacheStatements = cacheStatements))
+
+        try {
+            return measureTime {
+                repeat(INSERTS) { db.todosQueries.create("title $it", "content") }
+                repeat(QUERIES) { db.todosQueries.all().awaitAsList().size shouldBe INSERTS }
+            }
+        } finally {
+            powersync.close()
+        }
+    }
+
+    private companion object {
+        const val INSERTS = 2_000
+        const val QUERIES = 200
+
+        val schema =
+            Schema(
+                Table(
+                    "todos",
+                    listOf(
+                        Column.text("title"),
+                        Column.text("content"),
+                    ),
+                ),
+            )
+    }
+}
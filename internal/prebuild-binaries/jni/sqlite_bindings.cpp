@@ -162,6 +162,63 @@ static void JNICALL nativeConnectionClose(
     sqlite3_close_v2(db);
 }
 
+static jlong JNICALL nativeSessionCreate(
+        JNIEnv *env,
+        jclass clazz,
+        jlong dbPointer) {
+    sqlite3 *db = reinterpret_cast<sqlite3 *>(dbPointer);
+    sqlite3_session *session;
+    int rc = sqlite3session_create(db, "main", &session);
+    if (rc != SQLITE_OK) {
+        throwSQLiteException(env, rc, sqlite3_errmsg(db));
+        return 0;
+    }
+
+    // Record changes on all tables.
+    rc = sqlite3session_attach(session, nullptr);
+    if (rc != SQLITE_OK) {
+        sqlite3session_delete(session);
+        throwSQLiteException(env, rc, sqlite3_errmsg(db));
+        return 0;
+    }
+
+    return reinterpret_cast<jlong>(session);
+}
+
+static jbyteArray JNICALL nativeSessionChangeset(
+        JNIEnv *env,
+        jclass clazz,
+        jlong dbPointer,
+        jlong sessionPointer) {
+    sqlite3 *db = reinterpret_cast<sqlite3 *>(dbPointer);
+    sqlite3_session *session = reinterpret_cast<sqlite3_session *>(sessionPointer);
+    int size = 0;
+    void *buffer = nullptr;
+    int rc = sqlite3session_changeset(session, &size, &buffer);
+    if (rc != SQLITE_OK) {
+        throwSQLiteException(env, rc, sqlite3_errmsg(db));
+        return nullptr;
+    }
+
+    jbyteArray byteArray = nullptr;
+    if (size > 0) {
+        byteArray = env->NewByteArray(size);
+        if (byteArray != nullptr) {
+            env->SetByteArrayRegion(byteArray, 0, size, static_cast<const jbyte *>(buffer));
+        }
+    }
+    sqlite3_free(buffer);
+    return byteArray;
+}
+
+static void JNICALL nativeSessionDelete(
+        JNIEnv *env,
+        jclass clazz,
+        jlong sessionPointer) {
+    sqlite3_session *session = reinterpret_cast<sqlite3_session *>(sessionPointer);
+    sqlite3session_delete(session);
+}
+
 static void JNICALL nativeBindBlob(
         JNIEnv *env,
         jclass clazz,
@@ -377,7 +434,10 @@ static const JNINativeMethod sConnectionMethods[] = {
         {"nativeInTransaction", "(J)Z",                                     (void *) nativeInTransaction},
         {"nativePrepare",       "(JLjava/lang/String;)J",                   (void *) nativePrepare},
         {"nativeLoadExtension", "(JLjava/lang/String;Ljava/lang/String;)V", (void *) nativeLoadExtension},
-        {"nativeClose",         "(J)V",                                     (void *) nativeConnectionClose}
+        {"nativeClose",         "(J)V",                                     (void *) nativeConnectionClose},
+        {"nativeSessionCreate", "(J)J",                                     (void *) nativeSessionCreate},
+        {"nativeSessionChangeset", "(JJ)[B",                                (void *) nativeSessionChangeset},
+        {"nativeSessionDelete", "(J)V",                                     (void *) nativeSessionDelete}
 };
 
 static const JNINativeMethod sStatementMethods[] = {
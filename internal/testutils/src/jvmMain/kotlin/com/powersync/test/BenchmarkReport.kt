@@ -0,0 +1,19 @@
+package com.powersync.test
+
+import java.io.File
+
+/**
+ * Writes [results] of a benchmark run by the `jvmBenchmark` Gradle task to
+ * `build/reports/benchmarks/<name>.txt`.
+ *
+ * Nothing is written when the benchmark runs outside of that task.
+ */
+fun writeBenchmarkReport(
+    name: String,
+    results: Map<String, Any>,
+) {
+    val directory = System.getProperty("powersync.benchmarkReports") ?: return
+    val file = File(directory, "$name.txt")
+    file.parentFile.mkdirs()
+    file.writeText(results.entries.joinToString(separator = "\n", postfix = "\n") { (key, value) -> "$key: $value" })
+}
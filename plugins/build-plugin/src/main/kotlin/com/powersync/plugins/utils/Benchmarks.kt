@@ -0,0 +1,39 @@
+package com.powersync.plugins.utils
+
+import org.gradle.api.Project
+import org.gradle.language.base.plugins.LifecycleBasePlugin
+import org.jetbrains.kotlin.gradle.targets.jvm.tasks.KotlinJvmTest
+
+private const val BENCHMARK_TASK = "jvmBenchmark"
+private const val BENCHMARK_CLASSES = "*Benchmark"
+
+/**
+ * Runs `*Benchmark` classes of the JVM tests with a separate `jvmBenchmark` task instead of the
+ * regular test tasks.
+ *
+ * Benchmarks can use `writeBenchmarkReport` from the test utilities to record their results in
+ * `build/reports/benchmarks`.
+ */
+public fun Project.jvmBenchmarks() {
+    val testTask = tasks.named("jvmTest", KotlinJvmTest::class.java)
+    val reports = layout.buildDirectory.dir("reports/benchmarks")
+
+    tasks.withType(KotlinJvmTest::class.java).configureEach {
+        if (name != BENCHMARK_TASK) {
+            filter.excludeTestsMatching(BENCHMARK_CLASSES)
+        }
+    }
+
+    tasks.register(BENCHMARK_TASK, KotlinJvmTest::class.java) {
+        description = "Runs JVM benchmarks"
+        group = LifecycleBasePlugin.VERIFICATION_GROUP
+
+        classpath = testTask.get().classpath
+        testClassesDirs = testTask.get().testClassesDirs
+        filter.includeTestsMatching(BENCHMARK_CLASSES)
+        systemProperty("powersync.benchmarkReports", reports.get().asFile.absolutePath)
+
+        // Benchmark results are only useful when measured again.
+        outputs.upToDateWhen { false }
+    }
+}
@@ -17,13 +17,16 @@
 
 package com.powersync.encryption
 
-import androidx.sqlite.SQLiteConnection
 import androidx.sqlite.SQLiteStatement
 import androidx.sqlite.throwSQLiteException
+import com.powersync.ExperimentalPowerSyncAPI
+import com.powersync.db.driver.ChangesetSession
+import com.powersync.db.driver.SessionRecordingConnection
 
+@OptIn(ExperimentalPowerSyncAPI::class)
 internal class BundledSQLiteConnection(
     private val connectionPointer: Long,
-) : SQLiteConnection {
+) : SessionRecordingConnection {
     @Volatile private var isClosed = false
 
     override fun inTransaction(): Boolean {
@@ -52,18 +55,47 @@ internal class BundledSQLiteConnection(
         nativeLoadExtension(connectionPointer, fileName, entryPoint)
     }
 
+    override fun openChangesetSession(): ChangesetSession {
+        if (isClosed) {
+            throwSQLiteException(SQLITE_MISUSE, "connection is closed")
+        }
+
+        return BundledChangesetSession(connectionPointer, nativeSessionCreate(connectionPointer))
+    }
+
     override fun close() {
         if (!isClosed) {
             isClosed = true
             nativeClose(connectionPointer)
         }
     }
+}
+
+@OptIn(ExperimentalPowerSyncAPI::class)
+private class BundledChangesetSession(
+    private val connectionPointer: Long,
+    private val sessionPointer: Long,
+) : ChangesetSession {
+    private var isClosed = false
+
+    override fun changeset(): ByteArray? {
+        if (isClosed) {
+            throwSQLiteException(SQLITE_MISUSE, "session is closed")
+        }
 
-    private companion object {
-        private const val SQLITE_MISUSE = 21
+        return nativeSessionChangeset(connectionPointer, sessionPointer)
+    }
+
+    override fun close() {
+        if (!isClosed) {
+            isClosed = true
+            nativeSessionDelete(sessionPointer)
+        }
     }
 }
 
+private const val SQLITE_MISUSE = 21
+
 private external fun nativeInTransaction(pointer: Long): Boolean
 
 private external fun nativePrepare(
@@ -78,3 +110,12 @@ private external fun nativeLoadExtension(
 )
 
 private external fun nativeClose(pointer: Long)
+
+private external fun nativeSessionCreate(pointer: Long): Long
+
+private external fun nativeSessionChangeset(
+    pointer: Long,
+    sessionPointer: Long,
+): ByteArray?
+
+private external fun nativeSessionDelete(sessionPointer: Long)